@@ -0,0 +1,623 @@
+/*****************************************************************************/
+/**
+*  Brief: 	Contains implementation of the binary columnar log writer and reader.
+*
+*  Created: 16.10.2026
+*  Author: 	Yurii Shenbor
+*
+******************************************************************************/
+
+/***************************** Include Files ********************************/
+
+#include "bin_log.h"
+
+/************************** Function Prototypes ******************************/
+
+static int writeAll(int fd, const void *data, size_t size, off_t offset);
+static inline uint64_t zigzag(int64_t value);
+static inline int64_t unzigzag(uint64_t value);
+static inline uint8_t* putVarint(uint8_t *ptr, uint64_t value);
+static inline const uint8_t* getVarint(const uint8_t *ptr, const uint8_t *end, uint64_t *value);
+static size_t encodeBinLogBlock(struct bin_log_t *log);
+static int decodeBinLogBlock(struct bin_log_reader_t *reader, const struct bin_log_block_header_t *header);
+static int flushBinLogBlock(struct bin_log_t *log);
+static int scanBinLog(struct bin_log_reader_t *reader);
+
+/**************************************************************************/
+/**
+*
+* @brief    Writes the whole buffer at the given file offset
+*
+* @param	fd - file descriptor
+* @param	data - data to write
+* @param	size - size of the data
+* @param	offset - file offset
+*
+* @return	0 on success, otherwise -1
+*
+* @note		None
+*
+**************************************************************************/
+static int writeAll(int fd, const void *data, size_t size, off_t offset) {
+    const char *ptr = data;
+
+    while (size > 0) {
+        ssize_t status = pwrite(fd, ptr, size, offset);
+        if (status < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        ptr += status;
+        offset += status;
+        size -= status;
+    }
+
+    return 0;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Maps a signed value to an unsigned one, small magnitudes stay small
+*
+* @note		0, -1, 1, -2 ... become 0, 1, 2, 3 ...
+*
+**************************************************************************/
+static inline uint64_t zigzag(int64_t value) {
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Reverses zigzag
+*
+**************************************************************************/
+static inline int64_t unzigzag(uint64_t value) {
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Writes a value as a varint, 7 bits per byte, low bits first
+*
+* @param	ptr - position in the buffer, at least BIN_LOG_VARINT_MAX bytes free
+* @param	value - the value
+*
+* @return	position after the last written byte
+*
+**************************************************************************/
+static inline uint8_t* putVarint(uint8_t *ptr, uint64_t value) {
+    while (value >= 0x80) {
+        *ptr++ = (uint8_t)value | 0x80;
+        value >>= 7;
+    }
+    *ptr++ = (uint8_t)value;
+    return ptr;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Reads a varint
+*
+* @param	ptr - position in the buffer
+* @param	end - end of the buffer
+* @param	[out] value - the value
+*
+* @return	position after the varint, NULL if it is truncated or too long
+*
+* @note		Single byte varints, the common case, take one compare.
+*
+**************************************************************************/
+static inline const uint8_t* getVarint(const uint8_t *ptr, const uint8_t *end, uint64_t *value) {
+    uint64_t result = 0;
+
+    if (ptr < end && *ptr < 0x80) {
+        *value = *ptr;
+        return ptr + 1;
+    }
+
+    for (unsigned shift = 0; ptr < end && shift < 64; shift += 7) {
+        uint8_t byte = *ptr++;
+        result |= (uint64_t)(byte & 0x7f) << shift;
+        if (byte < 0x80) {
+            *value = result;
+            return ptr;
+        }
+    }
+
+    return NULL;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Creates a binary log and writes its header
+*
+* @param	[out] log - log writer
+* @param	path - path to the file, an existing file is truncated
+* @param	channels - number of value columns
+* @param	block_rows - rows per block, 0 for the default
+* @param	flags - BIN_LOG_* header flags
+*
+* @return	0 on success, otherwise -1
+*
+* @note		Nothing is allocated after opening, except for growing the block index.
+*
+**************************************************************************/
+int openBinLog(struct bin_log_t *log, const char *path, uint32_t channels, uint32_t block_rows, uint16_t flags) {
+    memset(log, 0, sizeof(*log));
+    log->channels = channels;
+    log->block_rows = (block_rows > 0) ? block_rows : BIN_LOG_BLOCK_ROWS;
+    log->offset = sizeof(log->header);
+
+    memcpy(log->header.magic, BIN_LOG_MAGIC, sizeof(BIN_LOG_MAGIC));
+    log->header.version = BIN_LOG_VERSION;
+    log->header.flags = flags;
+    log->header.channels = channels;
+    log->header.block_rows = log->block_rows;
+
+    log->timestamps = malloc(log->block_rows * sizeof(*log->timestamps));
+    log->values = malloc((size_t)log->block_rows * (channels ? channels : 1) * sizeof(*log->values));
+    if (flags & BIN_LOG_COMPRESSED) {
+        log->encoded = malloc((size_t)log->block_rows * (channels + 1) * BIN_LOG_VARINT_MAX);
+    }
+    if (log->timestamps == NULL || log->values == NULL || ((flags & BIN_LOG_COMPRESSED) && log->encoded == NULL)) {
+        free(log->timestamps);
+        free(log->values);
+        free(log->encoded);
+        return -1;
+    }
+
+    log->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (log->fd < 0 || writeAll(log->fd, &log->header, sizeof(log->header), 0) < 0) {
+        if (log->fd >= 0) {
+            close(log->fd);
+        }
+        free(log->timestamps);
+        free(log->values);
+        free(log->encoded);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Encodes the current block of a compressed log
+*
+* @param	log - log writer
+*
+* @return	size of the encoded columns
+*
+* @note		The first timestamp is kept in the block header. Timestamps of
+*           regularly spaced rows encode to a single zero byte, values of
+*           slowly changing signals to one byte per row.
+*
+**************************************************************************/
+static size_t encodeBinLogBlock(struct bin_log_t *log) {
+    uint8_t *ptr = log->encoded;
+    int64_t delta = 0;
+
+    for (uint32_t row = 1; row < log->rows; ++row) {
+        int64_t next = log->timestamps[row] - log->timestamps[row - 1];
+        ptr = putVarint(ptr, zigzag(next - delta));
+        delta = next;
+    }
+
+    for (uint32_t ch = 0; ch < log->channels; ++ch) {
+        const int32_t *column = &log->values[ch * log->block_rows];
+        int64_t previous = 0;
+
+        for (uint32_t row = 0; row < log->rows; ++row) {
+            ptr = putVarint(ptr, zigzag(column[row] - previous));
+            previous = column[row];
+        }
+    }
+
+    return ptr - log->encoded;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Writes the current block and adds it to the block index
+*
+* @param	log - log writer
+*
+* @return	0 on success, otherwise -1
+*
+* @note		Value columns are packed together (or encoded) first, so the block
+*           goes out with a single writev.
+*
+**************************************************************************/
+static int flushBinLogBlock(struct bin_log_t *log) {
+    uint32_t rows = log->rows;
+    size_t timestamps_size = rows * sizeof(*log->timestamps);
+    size_t values_size = (size_t)rows * log->channels * sizeof(*log->values);
+    static const uint64_t padding = 0;
+
+    if (rows == 0) {
+        return 0;
+    }
+
+    if (log->encoded != NULL) {
+        timestamps_size = encodeBinLogBlock(log);
+        values_size = 0;
+    } else if (rows < log->block_rows) {
+        for (uint32_t ch = 1; ch < log->channels; ++ch) {
+            memmove(&log->values[ch * rows], &log->values[ch * log->block_rows], rows * sizeof(*log->values));
+        }
+    }
+
+    size_t size = sizeof(struct bin_log_block_header_t) + timestamps_size + values_size;
+    struct bin_log_block_header_t block = {
+        .rows = rows,
+        .size = (size + 7) & ~(size_t)7,
+        .first_ms = log->timestamps[0],
+        .last_ms = log->timestamps[rows - 1],
+    };
+    struct iovec iov[4] = {
+        {&block, sizeof(block)},
+        {(log->encoded != NULL) ? (void *)log->encoded : (void *)log->timestamps, timestamps_size},
+        {log->values, values_size},
+        {(void *)&padding, block.size - size},
+    };
+
+    size_t written = 0;
+    while (written < block.size) {
+        ssize_t status = pwritev(log->fd, iov, 4, log->offset + written);
+        if (status < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        written += status;
+        // Skip the part that was written
+        for (int i = 0; i < 4; ++i) {
+            size_t done = ((size_t)status < iov[i].iov_len) ? (size_t)status : iov[i].iov_len;
+            iov[i].iov_base = (char *)iov[i].iov_base + done;
+            iov[i].iov_len -= done;
+            status -= done;
+        }
+    }
+
+    if (log->block_count == log->index_capacity) {
+        uint32_t capacity = log->index_capacity ? log->index_capacity * 2 : 64;
+        void *ptr = realloc(log->index, capacity * sizeof(*log->index));
+        if (ptr == NULL) {
+            return -1;
+        }
+        log->index = ptr;
+        log->index_capacity = capacity;
+    }
+
+    log->index[log->block_count++] = (struct bin_log_index_t){log->offset, block.first_ms, block.last_ms};
+    log->offset += block.size;
+    log->rows = 0;
+    return 0;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Adds a row with the values of all channels to the log
+*
+* @param	log - log writer
+* @param	timestamp - time of the row in milliseconds
+* @param	values - values of all channels
+*
+* @return	0 on success, otherwise -1
+*
+* @note		Timestamps are expected to be non-decreasing, seeking relies on it.
+*
+**************************************************************************/
+int appendBinLog(struct bin_log_t *log, int64_t timestamp, const struct sample_t *values) {
+    uint32_t row = log->rows++;
+
+    log->timestamps[row] = timestamp;
+    for (uint32_t ch = 0; ch < log->channels; ++ch) {
+        log->values[ch * log->block_rows + row] = values[ch].valid ? values[ch].value : BIN_LOG_INVALID;
+    }
+
+    return (log->rows == log->block_rows) ? flushBinLogBlock(log) : 0;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Writes the last block and the block index, then closes the log
+*
+* @param	log - log writer
+*
+* @return	0 on success, otherwise -1
+*
+* @note		None
+*
+**************************************************************************/
+int closeBinLog(struct bin_log_t *log) {
+    int status = flushBinLogBlock(log);
+
+    if (status == 0) {
+        status = writeAll(log->fd, log->index, log->block_count * sizeof(*log->index), log->offset);
+    }
+    if (status == 0) {
+        log->header.block_count = log->block_count;
+        log->header.index_offset = log->offset;
+        status = writeAll(log->fd, &log->header, sizeof(log->header), 0);
+    }
+
+    close(log->fd);
+    free(log->timestamps);
+    free(log->values);
+    free(log->encoded);
+    free(log->index);
+    memset(log, 0, sizeof(*log));
+    return status;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Rebuilds the block index of a log that was not closed
+*
+* @param	reader - log reader
+*
+* @return	0 on success, otherwise -1
+*
+* @note		A truncated last block is dropped.
+*
+**************************************************************************/
+static int scanBinLog(struct bin_log_reader_t *reader) {
+    size_t offset = sizeof(struct bin_log_header_t);
+    uint32_t capacity = 0;
+
+    reader->block_count = 0;
+    while (offset + sizeof(struct bin_log_block_header_t) <= reader->size) {
+        const struct bin_log_block_header_t *block = (const void *)(reader->map + offset);
+        if (block->rows == 0 || block->size == 0 || offset + block->size > reader->size) {
+            break;
+        }
+
+        if (reader->block_count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            void *ptr = realloc(reader->scanned, capacity * sizeof(*reader->scanned));
+            if (ptr == NULL) {
+                return -1;
+            }
+            reader->scanned = ptr;
+        }
+        reader->scanned[reader->block_count++] = (struct bin_log_index_t){offset, block->first_ms, block->last_ms};
+        offset += block->size;
+    }
+
+    reader->index = reader->scanned;
+    return 0;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Maps a binary log for reading
+*
+* @param	[out] reader - log reader
+* @param	path - path to the file
+*
+* @return	0 on success, otherwise -1
+*
+* @note		None
+*
+**************************************************************************/
+int openBinLogReader(struct bin_log_reader_t *reader, const char *path) {
+    struct stat info;
+    int fd = open(path, O_RDONLY);
+
+    memset(reader, 0, sizeof(*reader));
+    if (fd < 0) {
+        return -1;
+    }
+    if (fstat(fd, &info) < 0 || (size_t)info.st_size < sizeof(struct bin_log_header_t)) {
+        close(fd);
+        return -1;
+    }
+
+    reader->size = info.st_size;
+    reader->map = mmap(NULL, reader->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (reader->map == MAP_FAILED) {
+        reader->map = NULL;
+        return -1;
+    }
+    madvise(reader->map, reader->size, MADV_SEQUENTIAL);
+
+    reader->header = (const struct bin_log_header_t *)reader->map;
+    if (memcmp(reader->header->magic, BIN_LOG_MAGIC, sizeof(BIN_LOG_MAGIC)) != 0 ||
+        reader->header->version == 0 || reader->header->version > BIN_LOG_VERSION) {
+        closeBinLogReader(reader);
+        return -1;
+    }
+
+    if (reader->header->flags & BIN_LOG_COMPRESSED) {
+        uint32_t channels = reader->header->channels;
+        reader->timestamps = malloc((size_t)reader->header->block_rows * sizeof(*reader->timestamps));
+        reader->values = malloc((size_t)reader->header->block_rows * (channels ? channels : 1) * sizeof(*reader->values));
+        if (reader->timestamps == NULL || reader->values == NULL) {
+            closeBinLogReader(reader);
+            return -1;
+        }
+    }
+
+    uint64_t index_offset = reader->header->index_offset;
+    uint64_t index_size = (uint64_t)reader->header->block_count * sizeof(struct bin_log_index_t);
+    if (index_offset != 0 && index_offset + index_size <= reader->size) {
+        reader->index = (const struct bin_log_index_t *)(reader->map + index_offset);
+        reader->block_count = reader->header->block_count;
+    } else if (scanBinLog(reader) < 0) {
+        closeBinLogReader(reader);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Decodes a block of a compressed log into the reader buffers
+*
+* @param	reader - log reader
+* @param	header - header of the block in the mapped file
+*
+* @return	0 on success, -1 if the block is corrupted
+*
+* @note		Value column of channel c starts at c * rows.
+*
+**************************************************************************/
+static int decodeBinLogBlock(struct bin_log_reader_t *reader, const struct bin_log_block_header_t *header) {
+    const uint8_t *ptr = (const uint8_t *)(header + 1);
+    const uint8_t *end = (const uint8_t *)header + header->size;
+    const uint8_t *map_end = reader->map + reader->size;
+    uint32_t rows = header->rows;
+    int64_t timestamp = header->first_ms;
+    int64_t delta = 0;
+    uint64_t value;
+
+    // A bad size must not let the varints run past the map
+    if (end > map_end) {
+        end = map_end;
+    }
+    if (end < ptr || rows > reader->header->block_rows) {
+        return -1;
+    }
+
+    reader->timestamps[0] = timestamp;
+    for (uint32_t row = 1; row < rows; ++row) {
+        if ((ptr = getVarint(ptr, end, &value)) == NULL) {
+            return -1;
+        }
+        delta += unzigzag(value);
+        timestamp += delta;
+        reader->timestamps[row] = timestamp;
+    }
+
+    for (uint32_t ch = 0; ch < reader->header->channels; ++ch) {
+        int32_t *column = &reader->values[(size_t)ch * rows];
+        int64_t previous = 0;
+
+        for (uint32_t row = 0; row < rows; ++row) {
+            if ((ptr = getVarint(ptr, end, &value)) == NULL) {
+                return -1;
+            }
+            previous += unzigzag(value);
+            column[row] = (int32_t)previous;
+        }
+    }
+
+    return 0;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Gets columns of a block
+*
+* @param	reader - log reader
+* @param	block - block number
+* @param	[out] out - rows and column pointers of the block
+*
+* @return	0 on success, -1 if the block doesn't exist or is corrupted
+*
+* @note		No data is copied from an uncompressed log. A block of a compressed
+*           log is decoded into the reader and stays valid until the next call.
+*
+**************************************************************************/
+int getBinLogBlock(struct bin_log_reader_t *reader, uint32_t block, struct bin_log_block_t *out) {
+    if (block >= reader->block_count) {
+        return -1;
+    }
+
+    // The index and the block header come from the file, a corrupt log must not read past the map
+    uint64_t offset = reader->index[block].offset;
+    if (offset > reader->size || reader->size - offset < sizeof(struct bin_log_block_header_t)) {
+        return -1;
+    }
+
+    const uint8_t *ptr = reader->map + offset;
+    const struct bin_log_block_header_t *header = (const struct bin_log_block_header_t *)ptr;
+    uint64_t data_size = (uint64_t)header->rows * (sizeof(int64_t) + sizeof(int32_t) * reader->header->channels);
+    if (header->size > reader->size - offset || header->rows > reader->header->block_rows ||
+        (!(reader->header->flags & BIN_LOG_COMPRESSED) && header->size < sizeof(*header) + data_size)) {
+        return -1;
+    }
+
+    out->rows = header->rows;
+    out->stride = header->rows;
+    if (reader->header->flags & BIN_LOG_COMPRESSED) {
+        if (decodeBinLogBlock(reader, header) < 0) {
+            return -1;
+        }
+        out->timestamps = reader->timestamps;
+        out->values = reader->values;
+        return 0;
+    }
+    out->timestamps = (const int64_t *)(ptr + sizeof(*header));
+    out->values = (const int32_t *)(out->timestamps + header->rows);
+    return 0;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Finds the first block that may contain the given timestamp
+*
+* @param	reader - log reader
+* @param	timestamp - time in milliseconds
+*
+* @return	block number, block_count if all rows are older
+*
+* @note		Binary search over the block index.
+*
+**************************************************************************/
+uint32_t findBinLogBlock(const struct bin_log_reader_t *reader, int64_t timestamp) {
+    uint32_t low = 0, high = reader->block_count;
+
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        if (reader->index[mid].last_ms < timestamp) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Unmaps the log
+*
+* @param	reader - log reader
+*
+* @return	None
+*
+* @note		None
+*
+**************************************************************************/
+void closeBinLogReader(struct bin_log_reader_t *reader) {
+    if (reader->map != NULL) {
+        munmap(reader->map, reader->size);
+    }
+    free(reader->scanned);
+    free(reader->timestamps);
+    free(reader->values);
+    memset(reader, 0, sizeof(*reader));
+}
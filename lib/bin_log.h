@@ -0,0 +1,116 @@
+/*****************************************************************************/
+/**
+*  Brief: 	Contains definition for the binary columnar log format.
+*
+*           File layout (little-endian):
+*           [header 64 B][block 0][block 1]...[block index]
+*           Every block starts with a 24 B block header followed by the timestamp
+*           column (int64 ms, rows) and one value column per channel (int32 tenths
+*           of a volt, rows each, BIN_LOG_INVALID for "--"), padded to 8 bytes.
+*           The block index (first/last timestamp and offset of every block) is
+*           written when the log is closed, a log without it is still readable
+*           block by block.
+*
+*           In a compressed log (BIN_LOG_COMPRESSED) the block header is followed
+*           by varints instead: timestamps from the second row on as zigzag
+*           delta-of-delta, then every value column as zigzag deltas from the
+*           previous row (the first row from 0), padded to 8 bytes.
+*
+*  Created: 16.10.2026
+*  Author: 	Yurii Shenbor
+*
+******************************************************************************/
+
+#ifndef __BIN_LOG_H__
+#define __BIN_LOG_H__
+
+/***************************** Include Files ********************************/
+
+#include "client_lib.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/************************** Constant Definitions *****************************/
+
+#define BIN_LOG_MAGIC           "SIGLOG1"
+#define BIN_LOG_VERSION         2           // Version 1 logs (without compression) are still read
+#define BIN_LOG_BLOCK_ROWS      4096        // Default rows per block
+#define BIN_LOG_INVALID         INT32_MIN   // Stored value of a missing sample
+#define BIN_LOG_VARINT_MAX      10          // Longest varint of a 64-bit value
+
+// Header flags
+#define BIN_LOG_KEYS_DATA       0x0001      // JSON form uses the "data" key (tcp_logger), otherwise "outN"
+#define BIN_LOG_COMPRESSED      0x0002      // Blocks are delta and varint encoded
+
+/**************************** Type Definitions *******************************/
+
+struct bin_log_header_t {
+    char magic[8];
+    uint16_t version;
+    uint16_t flags;
+    uint32_t channels;
+    uint32_t block_rows;                // maximum rows per block
+    uint32_t block_count;               // valid only if index_offset is set
+    uint64_t index_offset;              // 0 if the log was not closed properly
+    uint8_t reserved[32];
+};
+
+struct bin_log_block_header_t {
+    uint32_t rows;
+    uint32_t size;                      // size of the whole block in bytes
+    int64_t first_ms;
+    int64_t last_ms;
+};
+
+struct bin_log_index_t {
+    uint64_t offset;
+    int64_t first_ms;
+    int64_t last_ms;
+};
+
+struct bin_log_t {
+    int fd;
+    uint32_t channels;
+    uint32_t block_rows;
+    uint32_t rows;                      // rows in the current block
+    uint64_t offset;                    // file offset of the current block
+    int64_t *timestamps;
+    int32_t *values;                    // column of channel c starts at c * block_rows
+    struct bin_log_index_t *index;
+    uint32_t block_count;
+    uint32_t index_capacity;
+    uint8_t *encoded;                   // encoded block of a compressed log
+    struct bin_log_header_t header;
+};
+
+// Block as seen by the reader, pointers point into the mapped file (or the decoded block)
+struct bin_log_block_t {
+    uint32_t rows;
+    uint32_t stride;                    // distance between value columns
+    const int64_t *timestamps;
+    const int32_t *values;              // column of channel c starts at c * stride
+};
+
+struct bin_log_reader_t {
+    uint8_t *map;
+    size_t size;
+    const struct bin_log_header_t *header;
+    const struct bin_log_index_t *index;
+    uint32_t block_count;
+    struct bin_log_index_t *scanned;    // index rebuilt by scanning a log that was not closed
+    int64_t *timestamps;                // decoded block of a compressed log
+    int32_t *values;
+};
+
+/************************** Function Prototypes ******************************/
+
+int openBinLog(struct bin_log_t *log, const char *path, uint32_t channels, uint32_t block_rows, uint16_t flags);
+int appendBinLog(struct bin_log_t *log, int64_t timestamp, const struct sample_t *values);
+int closeBinLog(struct bin_log_t *log);
+
+int openBinLogReader(struct bin_log_reader_t *reader, const char *path);
+int getBinLogBlock(struct bin_log_reader_t *reader, uint32_t block, struct bin_log_block_t *out);
+uint32_t findBinLogBlock(const struct bin_log_reader_t *reader, int64_t timestamp);
+void closeBinLogReader(struct bin_log_reader_t *reader);
+
+#endif /* __BIN_LOG_H__ */
@@ -0,0 +1,771 @@
+/*****************************************************************************/
+/**
+*  Brief: 	Contains implementation of the runtime channel table used by client apps.
+*
+*  Created: 16.10.2026
+*  Author: 	Yurii Shenbor
+*
+******************************************************************************/
+
+/***************************** Include Files ********************************/
+
+#include "channels.h"
+
+/************************** Function Prototypes ******************************/
+
+static int growChannelTable(struct channel_table_t *table);
+static inline void storeChannelSample(struct channel_table_t *table, uint32_t channel, struct sample_t sample);
+static void storeSample(struct port_t *port, struct sample_t sample, void *ctx);
+static void reactToSample(struct port_t *port, struct sample_t sample, void *ctx);
+
+/**************************************************************************/
+/**
+*
+* @brief    Initializes an empty channel table
+*
+* @param	[out] table - channel table
+*
+* @return	None
+*
+* @note		None
+*
+**************************************************************************/
+void initChannelTable(struct channel_table_t *table) {
+    memset(table, 0, sizeof(*table));
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Closes all channels and releases the table memory
+*
+* @param	table - channel table
+*
+* @return	None
+*
+* @note		None
+*
+**************************************************************************/
+void freeChannelTable(struct channel_table_t *table) {
+    for (size_t i = 0; i < table->count; ++i) {
+        if (table->ports[i].sockfd >= 0) {
+            close(table->ports[i].sockfd);
+        }
+    }
+
+    free(table->addr);
+    free(table->ports);
+    free(table->slots);
+    free(table->seen);
+    free(table->values);
+    free(table->aggregates);
+    free(table->aggregated);
+    initChannelTable(table);
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Doubles the capacity of all arrays of the table
+*
+* @param	table - channel table
+*
+* @return	0 on success, otherwise -1
+*
+* @note		New entries are zeroed.
+*
+**************************************************************************/
+static int growChannelTable(struct channel_table_t *table) {
+    size_t capacity = (table->capacity == 0) ? CHANNELS_MIN_CAPACITY : table->capacity * 2;
+    size_t added = capacity - table->capacity;
+    void *ptr;
+
+#define GROW_ARRAY(array) \
+    if ((ptr = realloc(table->array, capacity * sizeof(*table->array))) == NULL) { \
+        return -1; \
+    } \
+    table->array = ptr; \
+    memset(&table->array[table->capacity], 0, added * sizeof(*table->array));
+
+    GROW_ARRAY(addr);
+    GROW_ARRAY(ports);
+    GROW_ARRAY(slots);
+    GROW_ARRAY(seen);
+    GROW_ARRAY(values);
+#undef GROW_ARRAY
+
+    table->capacity = capacity;
+    return 0;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Adds a channel to the table
+*
+* @param	table - channel table
+* @param	endpoint - "host:port", or "port" to find the address of an open local port
+*
+* @return	index of the new channel, -1 if the endpoint is invalid
+*
+* @note		The same endpoint may be added several times, every channel has its own connection.
+*           A port without a host stays unresolved until resolveChannels is called.
+*
+**************************************************************************/
+int addChannel(struct channel_table_t *table, const char *endpoint) {
+    char host[256];
+    const char *port_str = strrchr(endpoint, ':');
+    struct sockaddr_in addr;
+
+    memset(&addr, 0, sizeof(addr));
+
+    if (port_str == NULL) {
+        // Only the port is given, its address is looked up with the other ones by resolveChannels
+        int port_number = atoi(endpoint);
+        if (port_number <= 0 || port_number > 65535) {
+            fprintf(stderr, "Invalid port: %s\n", endpoint);
+            return -1;
+        }
+        addr.sin_family = AF_UNSPEC;
+        addr.sin_port = htons(port_number);
+    } else {
+        size_t host_size = port_str - endpoint;
+        int port_number = atoi(port_str + 1);
+        if (host_size == 0 || host_size >= sizeof(host) || port_number <= 0 || port_number > 65535) {
+            fprintf(stderr, "Invalid endpoint: %s\n", endpoint);
+            return -1;
+        }
+        memcpy(host, endpoint, host_size);
+        host[host_size] = '\0';
+
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port_number);
+        if (inet_pton(AF_INET, host, &addr.sin_addr) != 1) {
+            struct addrinfo hints = {.ai_family = AF_INET, .ai_socktype = SOCK_STREAM};
+            struct addrinfo *result;
+            if (getaddrinfo(host, NULL, &hints, &result) != 0) {
+                fprintf(stderr, "Unable to resolve host: %s\n", host);
+                return -1;
+            }
+            addr.sin_addr = ((struct sockaddr_in *)result->ai_addr)->sin_addr;
+            freeaddrinfo(result);
+        }
+    }
+
+    if (table->count == table->capacity && growChannelTable(table) < 0) {
+        error_exit("Unable to grow channel table");
+    }
+
+    table->addr[table->count] = addr;
+    table->ports[table->count].sockfd = -1;
+    return table->count++;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Adds channels listed in a config file to the table
+*
+* @param	table - channel table
+* @param	path - path to the file, one endpoint per line, '#' starts a comment
+*
+* @return	number of channels added, -1 if the file can't be read or has an invalid entry
+*
+* @note		None
+*
+**************************************************************************/
+int loadChannels(struct channel_table_t *table, const char *path) {
+    FILE *fp = fopen(path, "r");
+    char line[512];
+    int count = 0;
+
+    if (!fp) {
+        perror("Unable to open channel config");
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), fp)) {
+        char *comment = strchr(line, '#');
+        if (comment != NULL) {
+            *comment = '\0';
+        }
+
+        char *endpoint = strtok(line, " \t\r\n");
+        while (endpoint != NULL) {
+            if (addChannel(table, endpoint) < 0) {
+                fclose(fp);
+                return -1;
+            }
+            count++;
+            endpoint = strtok(NULL, " \t\r\n");
+        }
+    }
+
+    fclose(fp);
+    return count;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Finds the addresses of all channels given only by a port
+*
+* @param	table - channel table
+*
+* @return	0 on success, -1 if a port is not open
+*
+* @note		All ports are looked up in a single pass over /proc/net/tcp and tcp6.
+*
+**************************************************************************/
+int resolveChannels(struct channel_table_t *table) {
+    uint16_t *ports = malloc((table->count ? table->count : 1) * sizeof(*ports));
+    size_t *index = malloc((table->count ? table->count : 1) * sizeof(*index));
+    struct sockaddr_in *addr = calloc(table->count ? table->count : 1, sizeof(*addr));
+    size_t count = 0;
+    int status = 0;
+
+    if (ports == NULL || index == NULL || addr == NULL) {
+        error_exit("Unable to resolve channels");
+    }
+
+    for (size_t i = 0; i < table->count; ++i) {
+        if (table->addr[i].sin_family == AF_UNSPEC) {
+            ports[count] = ntohs(table->addr[i].sin_port);
+            index[count++] = i;
+        }
+    }
+
+    if (count > 0 && findOpenPorts(ports, count, addr) < count) {
+        status = -1;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        if (addr[i].sin_family == AF_UNSPEC) {
+            fprintf(stderr, "An open port could not be found: %u, give it as host:port\n", ports[i]);
+        } else {
+            table->addr[index[i]] = addr[i];
+        }
+    }
+
+    free(ports);
+    free(index);
+    free(addr);
+    return status;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Publishes a sample into the slot of its channel and adds it to the aggregates
+*
+* @param	table - channel table
+* @param	channel - index of the channel
+* @param	sample - the received value
+*
+* @return	None
+*
+* @note		None
+*
+**************************************************************************/
+static inline void storeChannelSample(struct channel_table_t *table, uint32_t channel, struct sample_t sample) {
+    publishSample(&table->slots[channel], sample);
+    if (table->aggregates != NULL) {
+        aggregateSample(&table->aggregates[channel], &table->epoch, sample);
+    }
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Publishes every sample of a channel into its slot
+*
+* @param	port - port the sample was received from
+* @param	sample - the received value
+* @param	ctx - channel table
+*
+* @return	None
+*
+* @note		None
+*
+**************************************************************************/
+static void storeSample(struct port_t *port, struct sample_t sample, void *ctx) {
+    storeChannelSample((struct channel_table_t *)ctx, port->channel, sample);
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Publishes a sample into its slot and evaluates the control rules at once
+*
+* @param	port - port the sample was received from
+* @param	sample - the received value
+* @param	ctx - reactor of the reader thread
+*
+* @return	None
+*
+* @note		Read-backs are collected here as well, the controls belong to this thread.
+*
+**************************************************************************/
+static void reactToSample(struct port_t *port, struct sample_t sample, void *ctx) {
+    struct reactor_t *reactor = (struct reactor_t *)ctx;
+
+    storeChannelSample(reactor->table, port->channel, sample);
+    evaluateRules(&reactor->rules, port->channel, sample, port->recv_ns);
+    pollReactor(reactor);
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Starts connecting to all channels of the table
+*
+* @param	table - channel table
+*
+* @return	None
+*
+* @note		Raises the open file limit if the table needs more descriptors.
+*           Metrics, if enabled, must be initialized before. Connects are
+*           non-blocking and run in parallel, the event loops of the channels
+*           finish them and reconnect lost connections in the background.
+*
+**************************************************************************/
+void connectChannels(struct channel_table_t *table) {
+    struct rlimit limit;
+
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < table->count + 64) {
+        limit.rlim_cur = (limit.rlim_max < table->count + 64) ? limit.rlim_max : table->count + 64;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    for (size_t i = 0; i < table->count; ++i) {
+        table->ports[i].on_sample = storeSample;
+        table->ports[i].ctx = table;
+        table->ports[i].stats = (client_stats != NULL) ? &client_stats->ports[i] : NULL;
+        table->ports[i].channel = i;
+        table->ports[i].addr = &table->addr[i];
+        startConnect(&table->ports[i]);
+    }
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Starts reader threads, every thread serves its own share of the channels
+*
+* @param	table - channel table
+* @param	reader_count - number of threads, limited by the number of channels
+* @param	[out] loops - event loop of every reader
+* @param	[out] threads - thread id of every reader
+*
+* @return	number of threads started
+*
+* @note		None
+*
+**************************************************************************/
+int startReaders(struct channel_table_t *table, int reader_count, struct event_loop_t *loops, pthread_t *threads) {
+    size_t first = 0;
+
+    if ((size_t)reader_count > table->count) {
+        reader_count = table->count;
+    }
+
+    for (int i = 0; i < reader_count; ++i) {
+        size_t last = table->count * (i + 1) / reader_count;
+
+        if (initEventLoop(&loops[i], &table->ports[first], last - first, 0) < 0) {
+            error_exit("Unable to start event loop");
+        }
+        if (pthread_create(&threads[i], NULL, readFromPortsInThread, (void *)&loops[i]) != 0) {
+            error_exit("Unable to start reader thread");
+        }
+        first = last;
+    }
+
+    return reader_count;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Assigns a raw sample ring to every channel
+*
+* @param	table - channel table
+* @param	shard_count - number of threads the channels are split between, as in startReaders
+*
+* @return	None
+*
+* @note		Every thread publishes into its own ring, so every ring has a single
+*           producer. Does nothing if raw samples are not published.
+*
+**************************************************************************/
+void attachRings(struct channel_table_t *table, int shard_count) {
+    size_t first = 0;
+
+    if ((size_t)shard_count > table->count) {
+        shard_count = table->count;
+    }
+
+    for (int i = 0; i < shard_count; ++i) {
+        size_t last = table->count * (i + 1) / shard_count;
+        struct shm_ring_t *ring = getRing(client_rings, i + 1);
+
+        for (size_t ch = first; ch < last; ++ch) {
+            table->ports[ch].ring = ring;
+        }
+        first = last;
+    }
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Opens a control for every distinct server host of the channel table
+*
+* @param	[out] reactor - reactor, its rules are not touched
+* @param	table - channel table, resolved
+* @param	udp_port - control port of the servers
+* @param	ack - read every written property back
+*
+* @return	0 on success, otherwise -1
+*
+* @note		Channels on the same host share a control, control_of maps a channel
+*           to it.
+*
+**************************************************************************/
+int initReactor(struct reactor_t *reactor, const struct channel_table_t *table, int udp_port, int ack) {
+    size_t count = table->count ? table->count : 1;
+
+    reactor->control_count = 0;
+    reactor->controls = calloc(count, sizeof(*reactor->controls));
+    reactor->control_of = calloc(count, sizeof(*reactor->control_of));
+    if (reactor->controls == NULL || reactor->control_of == NULL) {
+        return -1;
+    }
+
+    for (size_t ch = 0; ch < table->count; ++ch) {
+        size_t i = 0;
+
+        while (i < reactor->control_count &&
+               reactor->controls[i].addr.sin_addr.s_addr != table->addr[ch].sin_addr.s_addr) {
+            ++i;
+        }
+        if (i == reactor->control_count) {
+            struct in_addr host = table->addr[ch].sin_addr;
+
+            if (initControl(&reactor->controls[i], &host, udp_port, ack) < 0) {
+                return -1;
+            }
+            reactor->control_count++;
+        }
+        reactor->control_of[ch] = i;
+    }
+    return 0;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Closes the controls of a reactor
+*
+* @param	reactor - reactor
+*
+* @return	None
+*
+* @note		The rules are not freed.
+*
+**************************************************************************/
+void closeReactor(struct reactor_t *reactor) {
+    for (size_t i = 0; i < reactor->control_count; ++i) {
+        closeControl(&reactor->controls[i]);
+    }
+    free(reactor->controls);
+    free(reactor->control_of);
+    reactor->controls = NULL;
+    reactor->control_of = NULL;
+    reactor->control_count = 0;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Collects the read-backs of every control of a reactor
+*
+* @param	reactor - reactor
+*
+* @return	None
+*
+* @note		Controls without writes waiting for a read-back are skipped.
+*
+**************************************************************************/
+void pollReactor(struct reactor_t *reactor) {
+    for (size_t i = 0; i < reactor->control_count; ++i) {
+        if (reactor->controls[i].pending_count > 0) {
+            pollAcks(&reactor->controls[i]);
+        }
+    }
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Makes every reader thread evaluate the control rules for its channels
+*
+* @param	table - channel table, connected
+* @param	shard_count - number of threads the channels are split between, as in startReaders
+* @param	reactors - reactor of every thread, with the controls and rules initialized
+*
+* @return	None
+*
+* @note		Samples are still published into the slots for the tick.
+*
+**************************************************************************/
+void attachReactors(struct channel_table_t *table, int shard_count, struct reactor_t *reactors) {
+    size_t first = 0;
+
+    if ((size_t)shard_count > table->count) {
+        shard_count = table->count;
+    }
+
+    for (int i = 0; i < shard_count; ++i) {
+        size_t last = table->count * (i + 1) / shard_count;
+
+        reactors[i].table = table;
+        for (size_t ch = first; ch < last; ++ch) {
+            table->ports[ch].on_sample = reactToSample;
+            table->ports[ch].ctx = &reactors[i];
+        }
+        first = last;
+    }
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Takes the latest value of every channel for the current tick
+*
+* @param	table - channel table
+*
+* @return	None
+*
+* @note		A channel without a new value since the previous tick is marked invalid.
+*
+**************************************************************************/
+void snapshotChannels(struct channel_table_t *table) {
+    for (size_t i = 0; i < table->count; ++i) {
+        uint32_t seq = snapshotSample(&table->slots[i], &table->values[i]);
+        if (seq == table->seen[i]) {
+            table->values[i].valid = 0;
+            if (table->ports[i].stats != NULL) {
+                statsAdd(&table->ports[i].stats->missing, 1);
+            }
+        }
+        table->seen[i] = seq;
+    }
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Allocates the running aggregates of all channels
+*
+* @param	table - channel table with all channels added
+*
+* @return	0 on success, otherwise -1
+*
+* @note		Must be called before the readers start, the table must not grow afterwards.
+*
+**************************************************************************/
+int enableAggregates(struct channel_table_t *table) {
+    size_t count = table->count ? table->count : 1;
+
+    table->aggregates = calloc(count, sizeof(*table->aggregates));
+    table->aggregated = calloc(count, sizeof(*table->aggregated));
+    if (table->aggregates == NULL || table->aggregated == NULL) {
+        free(table->aggregates);
+        free(table->aggregated);
+        table->aggregates = NULL;
+        table->aggregated = NULL;
+        return -1;
+    }
+
+    atomic_store_explicit(&table->epoch, 0, memory_order_relaxed);
+    return 0;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Closes the current aggregation period and takes its aggregates
+*
+* @param	table - channel table
+*
+* @return	None
+*
+* @note		Readers move to the next period at once, the aggregates of the closed
+*           one are left in table->aggregated. A sample being added while the
+*           period is closed is waited for, so it counts in the closed period.
+*
+**************************************************************************/
+void closeAggregates(struct channel_table_t *table) {
+    uint32_t epoch = atomic_fetch_add_explicit(&table->epoch, 1, memory_order_seq_cst);
+
+    atomic_thread_fence(memory_order_seq_cst);
+    for (size_t i = 0; i < table->count; ++i) {
+        struct aggregate_half_t *half = &table->aggregates[i].half[epoch & 1];
+
+        // A reader that marked the half before the epoch moved still writes into it
+        while (atomic_load_explicit(&half->seq, memory_order_acquire) & 1) {
+        }
+        takeAggregate(&table->aggregates[i], epoch, &table->aggregated[i]);
+    }
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Parses command line options common for client apps
+*
+* @param	argc - number of arguments
+* @param	argv - arguments
+* @param	[in,out] options - options, prefilled with the defaults of the app
+* @param	[out] table - channel table filled with the given endpoints
+*
+* @return	0 on success, otherwise -1
+*
+* @note		Without endpoints the default ports 4001 ... 4003 are used. The control
+*           options (-A, -E, -r, -t, -u) are rejected unless options->control is set.
+*
+**************************************************************************/
+int parseClientOptions(int argc, char *argv[], struct client_options_t *options, struct channel_table_t *table) {
+    const char *optstring = options->control ? "a:Ab:c:D:Ef:F:i:KP:r:R:St:u:w:h" : "a:b:c:D:f:F:i:KP:R:Sw:h";
+    int opt;
+
+    while ((opt = getopt(argc, argv, optstring)) != -1) {
+        switch (opt) {
+        case 'a':
+            if ((options->aggregates = parseAggregates(optarg)) == 0) {
+                fprintf(stderr, "Unknown aggregates: %s\n", optarg);
+                return -1;
+            }
+            break;
+        case 'A':
+            options->ack = 1;
+            break;
+        case 'b':
+            if (strcmp(optarg, "epoll") == 0) {
+                event_backend = BACKEND_EPOLL;
+            } else if (strcmp(optarg, "io_uring") == 0) {
+                event_backend = BACKEND_IO_URING;
+            } else {
+                fprintf(stderr, "Unknown backend: %s\n", optarg);
+                return -1;
+            }
+            break;
+        case 'c':
+            if (loadChannels(table, optarg) < 0) {
+                return -1;
+            }
+            break;
+        case 'D':
+            options->decimation = strtoul(optarg, NULL, 10);
+            break;
+        case 'E':
+            options->react = 1;
+            break;
+        case 'f':
+            options->flush_lines = strtoul(optarg, NULL, 10);
+            break;
+        case 'F':
+            options->flush_ms = strtoul(optarg, NULL, 10);
+            break;
+        case 'i':
+            options->tick_ms = strtoul(optarg, NULL, 10);
+            break;
+        case 'K':
+            receive_timestamps = 1;
+            break;
+        case 'P':
+            options->realtime = 1;
+            options->realtime_cpu = atoi(optarg);
+            break;
+        case 'r':
+            options->rules = optarg;
+            break;
+        case 'R':
+            if (strcmp(optarg, "ticks") == 0) {
+                options->rings = 1;
+            } else if (strcmp(optarg, "all") == 0) {
+                options->rings = 2;
+            } else {
+                fprintf(stderr, "Unknown ring mode: %s\n", optarg);
+                return -1;
+            }
+            break;
+        case 'S':
+            options->stats = 1;
+            break;
+        case 't':
+            options->reader_threads = atoi(optarg);
+            break;
+        case 'u':
+            options->udp_port = strtoul(optarg, NULL, 10);
+            break;
+        case 'w':
+            options->binary_log = optarg;
+            break;
+        default:
+            if (options->control) {
+                fprintf(stderr, "Usage: %s [-a min,max,mean,count,last] [-A] [-b epoll|io_uring] [-c channel_file] [-D ticks] [-E] [-f flush_lines] [-F flush_ms] [-i tick_ms] [-K] [-P cpu] [-r rules_file] [-R ticks|all] [-S] [-t reader_threads] [-u udp_port] [-w binary_log] [host:port | port ...]\n", argv[0]);
+            } else {
+                fprintf(stderr, "Usage: %s [-a min,max,mean,count,last] [-b epoll|io_uring] [-c channel_file] [-D ticks] [-f flush_lines] [-F flush_ms] [-i tick_ms] [-K] [-P cpu] [-R ticks|all] [-S] [-w binary_log] [host:port | port ...]\n", argv[0]);
+            }
+            return -1;
+        }
+    }
+
+    for (int i = optind; i < argc; ++i) {
+        if (addChannel(table, argv[i]) < 0) {
+            return -1;
+        }
+    }
+
+    if (table->count == 0) {
+        for (int port = 0; port < MAX_PORTS; port++) {
+            char endpoint[16];
+            snprintf(endpoint, sizeof(endpoint), "%d", port + TCP_PORT);
+            if (addChannel(table, endpoint) < 0) {
+                return -1;
+            }
+        }
+    }
+
+    if (resolveChannels(table) < 0) {
+        return -1;
+    }
+
+    if (options->tick_ms == 0) {
+        fprintf(stderr, "Tick period must be greater than 0\n");
+        return -1;
+    }
+    if (options->realtime && (options->realtime_cpu < 0 || options->realtime_cpu >= sysconf(_SC_NPROCESSORS_CONF))) {
+        fprintf(stderr, "Invalid CPU: %d\n", options->realtime_cpu);
+        return -1;
+    }
+    if (options->decimation == 0) {
+        options->decimation = 1;
+    }
+    if (options->aggregates != 0 && enableAggregates(table) < 0) {
+        fprintf(stderr, "Failed to allocate aggregates\n");
+        return -1;
+    }
+    if (options->udp_port == 0 || options->udp_port > 65535) {
+        options->udp_port = UDP_PORT;
+    }
+    if (options->reader_threads <= 0) {
+        options->reader_threads = (table->count < DEFAULT_READERS) ? table->count : DEFAULT_READERS;
+    }
+    if ((size_t)options->reader_threads > table->count) {
+        options->reader_threads = table->count;
+    }
+
+    return 0;
+}
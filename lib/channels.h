@@ -0,0 +1,94 @@
+/*****************************************************************************/
+/**
+*  Brief: 	Contains definition for the runtime channel table used by client apps.
+*
+*  Created: 16.10.2026
+*  Author: 	Yurii Shenbor
+*
+******************************************************************************/
+
+#ifndef __CHANNELS_H__
+#define __CHANNELS_H__
+
+/***************************** Include Files ********************************/
+
+#include "client_lib.h"
+#include "stats.h"
+#include "shm_ring.h"
+#include "rules.h"
+#include "output.h"
+#include <netdb.h>
+#include <getopt.h>
+#include <sys/resource.h>
+
+/************************** Constant Definitions *****************************/
+
+#define CHANNELS_MIN_CAPACITY   16
+#define DEFAULT_READERS         4      // Upper limit of reader threads if not given
+#define CLIENT_LOG_ROWS         256    // Ticks per block of the binary log, a killed client loses at most one block
+
+/**************************** Type Definitions *******************************/
+
+// Channels are kept as a struct-of-arrays, the tick walks only the slots and values
+struct channel_table_t {
+    size_t count;
+    size_t capacity;
+    struct sockaddr_in *addr;       // endpoint of every channel
+    struct port_t *ports;           // connection and receive ring of every channel
+    struct sample_slot_t *slots;    // latest value of every channel, written by the readers
+    uint32_t *seen;                 // slot sequence consumed by the previous tick
+    struct sample_t *values;        // values of the current tick
+    struct aggregate_slot_t *aggregates;    // running aggregates of every channel, NULL if not enabled
+    struct sample_aggregate_t *aggregated;  // aggregates of the period closed by the last tick
+    _Atomic uint32_t epoch;         // current aggregation period
+};
+
+// Control rules evaluated on the reader path, one instance per reader thread
+struct reactor_t {
+    struct channel_table_t *table;  // table the samples are stored in
+    struct control_t *controls;     // one control per distinct server host
+    size_t control_count;
+    uint32_t *control_of;           // index in controls of every channel
+    struct rules_t rules;
+};
+
+struct client_options_t {
+    int control;                    // accept the control options of client2 (-A, -E, -r, -t, -u)
+    unsigned long tick_ms;          // output period
+    int reader_threads;             // number of reader threads, 0 for default
+    unsigned flush_lines;           // output lines buffered before a write, 0 or 1 for every line
+    unsigned long flush_ms;         // longest time a line may stay buffered, 0 to ignore
+    const char *binary_log;         // path of the binary log of all ticks, NULL for none
+    int stats;                      // publish metrics in /dev/shm
+    int ack;                        // read every control write back
+    const char *rules;              // path of the control rules, NULL for the default ones
+    int react;                      // evaluate the rules on the reader path for every sample
+    int rings;                      // 0 - none, 1 - publish ticks, 2 - also every raw sample in /dev/shm
+    unsigned udp_port;              // control port of the signal server, 0 for the default
+    int realtime;                   // pin the tick thread, lock memory and use SCHED_FIFO
+    int realtime_cpu;               // CPU of the tick thread in realtime mode
+    unsigned aggregates;            // aggregates written per channel (enum aggregate_e), 0 for the last value only
+    unsigned decimation;            // ticks per output line, samples are aggregated over all of them
+};
+
+/************************** Function Prototypes ******************************/
+
+void initChannelTable(struct channel_table_t *table);
+void freeChannelTable(struct channel_table_t *table);
+int addChannel(struct channel_table_t *table, const char *endpoint);
+int loadChannels(struct channel_table_t *table, const char *path);
+int resolveChannels(struct channel_table_t *table);
+void connectChannels(struct channel_table_t *table);
+int startReaders(struct channel_table_t *table, int reader_count, struct event_loop_t *loops, pthread_t *threads);
+void attachRings(struct channel_table_t *table, int shard_count);
+int initReactor(struct reactor_t *reactor, const struct channel_table_t *table, int udp_port, int ack);
+void closeReactor(struct reactor_t *reactor);
+void pollReactor(struct reactor_t *reactor);
+void attachReactors(struct channel_table_t *table, int shard_count, struct reactor_t *reactors);
+void snapshotChannels(struct channel_table_t *table);
+int enableAggregates(struct channel_table_t *table);
+void closeAggregates(struct channel_table_t *table);
+
+int parseClientOptions(int argc, char *argv[], struct client_options_t *options, struct channel_table_t *table);
+
+#endif /* __CHANNELS_H__ */
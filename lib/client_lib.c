@@ -9,37 +9,24 @@
 
 /***************************** Include Files ********************************/
 
-#include "client_lib.h"
-
-/************************** Constant Definitions *****************************/
-
-#define MSG_MAX_SIZE    4
-
-/**************************** Type Definitions *******************************/
+#define _GNU_SOURCE     // CPU_SET, pthread_setaffinity_np
 
-enum operation_e {
-    READ = 1,
-    WRITE = 2
-};
-
-enum object_e {
-    CHANNEL_1 = 1,
-    CHANNEL_2 = 2,
-    CHANNEL_3 = 3
-};
-
-enum property_e {
-    ENABLED = 14,
-    MIN_DURATION = 42,  // For channel 3 only
-    MAX_DURATION = 43,  // For channel 3 only
-    AMPLITUDE = 170,
-    FREQUENCY = 255,
-    GLITCH_CHANCE = 300
-};
+#include "client_lib.h"
+#include "uring.h"
+#include "stats.h"
+#include "shm_ring.h"
+#include <sched.h>
+#include <sys/mman.h>
+#include <math.h>
 
-/************************** Function Prototypes ******************************/
+/************************** Variable Definitions *****************************/
 
-static int makeMessage(enum operation_e op, enum object_e obj, enum property_e prop, uint16_t val, uint16_t *msg);
+#ifdef HAVE_IO_URING
+enum backend_e event_backend = BACKEND_IO_URING;
+#else
+enum backend_e event_backend = BACKEND_EPOLL;
+#endif
+int receive_timestamps = 0;
 
 /**************************************************************************/
 /**
@@ -61,269 +48,1361 @@ void error_exit(const char *msg) {
 /**************************************************************************/
 /**
 *
-* @brief    Changes behavior of output 1 based on value from output 3
+* @brief    Parses a fixed number of hex digits
+*
+* @param	pos - the digits
+* @param	digits - number of digits
+* @param	[out] value - the value
+*
+* @return	position after the digits, NULL if a character is not a hex digit
+*
+**************************************************************************/
+static const char* parseHex(const char *pos, int digits, uint32_t *value) {
+    uint32_t result = 0;
+
+    for (int i = 0; i < digits; ++i, ++pos) {
+        char c = *pos;
+        if (c >= '0' && c <= '9') {
+            result = (result << 4) | (c - '0');
+        } else if (c >= 'A' && c <= 'F') {
+            result = (result << 4) | (c - 'A' + 10);
+        } else if (c >= 'a' && c <= 'f') {
+            result = (result << 4) | (c - 'a' + 10);
+        } else {
+            return NULL;
+        }
+    }
+
+    *value = result;
+    return pos;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Collects the listening sockets of wanted ports from a /proc/net/tcp* file
 *
-* @param	data - a pointer to the value from output 3
-* @param	sockfd - socket file descriptor
-* @param	udp_server_addr - the structure describing an Internet socket address
+* @param	path - /proc/net/tcp or /proc/net/tcp6
+* @param	words - 32-bit words of an address in the file, 1 or 4
+* @param	wanted - bitmap of the wanted ports
+* @param	[in,out] found - bitmap of the ports found so far
+* @param	[out] listen_addr - address of every found port in network byte order
 *
 * @return	None
 *
-* @note		None
+* @note		A missing file (i.e. no IPv6) is not an error. Addresses are printed as
+*           32-bit words in host byte order, so a word is the address as stored in
+*           memory. A wildcard listener is reached over loopback, an IPv6 one only
+*           if it also accepts IPv4 (wildcard or IPv4-mapped address).
 *
 **************************************************************************/
-void changeBehavior(char *data, int udp_sokfd, struct sockaddr_in *udp_server_addr) {
-    static int last_value = 3;
-
-    if (data[1] != '-') {
-        int current_value = atoi(data);
-        
-        if (last_value != current_value) {
-            uint16_t msg[MSG_MAX_SIZE];
-            if (current_value >= 3) {
-                // Set the frequency of server output 1 to 1Hz and amplitude to 8000
-                int size = makeMessage(WRITE, CHANNEL_1, FREQUENCY, 1000, msg);
-                sendMessage(udp_sokfd, udp_server_addr, msg, size);
-                size = makeMessage(WRITE, CHANNEL_1, AMPLITUDE, 8000, msg);
-                sendMessage(udp_sokfd, udp_server_addr, msg, size);
-            } else {
-                // Set the frequency of server output 1 to 2Hz and amplitude to 4000
-                int size = makeMessage(WRITE, CHANNEL_1, FREQUENCY, 2000, msg);
-                sendMessage(udp_sokfd, udp_server_addr, msg, size);
-                size = makeMessage(WRITE, CHANNEL_1, AMPLITUDE, 4000, msg);
-                sendMessage(udp_sokfd, udp_server_addr, msg, size);
+static void scanListeners(const char *path, int words, const uint64_t *wanted, uint64_t *found, uint32_t *listen_addr) {
+    FILE *fp = fopen(path, "r");
+    char line[256];
+
+    if (!fp) {
+        return;
+    }
+
+    // Skip the first line (header)
+    if (fgets(line, sizeof(line), fp) == NULL) {
+        fclose(fp);
+        return;
+    }
+
+    while (fgets(line, sizeof(line), fp)) {
+        // "   0: 0100007F:0FA1 00000000:0000 0A ...", fields have fixed widths
+        const char *pos = strchr(line, ':');
+        uint32_t addr[4], port, state;
+
+        if (pos == NULL) {
+            continue;
+        }
+        pos += 2;
+        for (int w = 0; w < words && pos != NULL; ++w) {
+            pos = parseHex(pos, 8, &addr[w]);
+        }
+        if (pos == NULL || *pos != ':' || (pos = parseHex(pos + 1, 4, &port)) == NULL) {
+            continue;
+        }
+        if (parseHex(pos + 1 + 8 * words + 1 + 4 + 1, 2, &state) == NULL || state != 0x0a) {
+            continue;
+        }
+        if (!(wanted[port >> 6] & (1ull << (port & 63))) || (found[port >> 6] & (1ull << (port & 63)))) {
+            continue;
+        }
+
+        uint32_t ipv4 = addr[0];
+        if (words == 4) {
+            if (addr[0] != 0 || addr[1] != 0 || (addr[2] != 0 && addr[2] != htonl(0x0000FFFF)) ||
+                (addr[2] == 0 && addr[3] != 0)) {
+                continue;       // IPv6 only, not reachable with an IPv4 address
             }
-            last_value = current_value;
+            ipv4 = addr[3];
         }
+
+        listen_addr[port] = (ipv4 == htonl(INADDR_ANY)) ? htonl(INADDR_LOOPBACK) : ipv4;
+        found[port >> 6] |= 1ull << (port & 63);
     }
+
+    fclose(fp);
 }
 
 /**************************************************************************/
 /**
 *
-* @brief    Creates UDP message
+* @brief    Finds the addresses of open local ports in a single pass
 *
-* @param	op - operation
-* @param	obj - object
-* @param	prop - property
-* @param	val - value for write opperations
-* @param	[out] msg - the array into which the message will be placed
+* @param	ports - port numbers, may repeat
+* @param	count - number of ports
+* @param	[out] tcp_server_addr - address of every port, left untouched if it is not open
 *
-* @return	size of the message in bytes
+* @return	number of ports found
 *
-* @note		None
+* @note		/proc/net/tcp and /proc/net/tcp6 are each read once for all ports,
+*           the wanted ports are kept in a bitmap, so the cost does not depend on
+*           the number of ports.
 *
 **************************************************************************/
-static int makeMessage(enum operation_e op, enum object_e obj, enum property_e prop, uint16_t val, uint16_t *msg) {
-    int size = 0;
+size_t findOpenPorts(const uint16_t *ports, size_t count, struct sockaddr_in *tcp_server_addr) {
+    uint64_t wanted[65536 / 64] = {0}, found[65536 / 64] = {0};
+    uint32_t *listen_addr = malloc(65536 * sizeof(*listen_addr));
+    size_t found_count = 0;
 
-    if (msg == NULL) {
-        return 0;
+    if (listen_addr == NULL) {
+        error_exit("Malloc failed");
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        wanted[ports[i] >> 6] |= 1ull << (ports[i] & 63);
     }
 
-    msg[size++] = (uint16_t)op;
-    msg[size++] = (uint16_t)obj;
-    msg[size++] = (uint16_t)prop;
+    scanListeners("/proc/net/tcp", 1, wanted, found, listen_addr);
+    scanListeners("/proc/net/tcp6", 4, wanted, found, listen_addr);
 
-    if (op == WRITE) {
-        msg[size++] = (uint16_t)val;
+    for (size_t i = 0; i < count; ++i) {
+        if (found[ports[i] >> 6] & (1ull << (ports[i] & 63))) {
+            tcp_server_addr[i].sin_family = AF_INET;
+            tcp_server_addr[i].sin_port = htons(ports[i]);
+            tcp_server_addr[i].sin_addr.s_addr = listen_addr[ports[i]];
+            found_count++;
+        }
     }
 
-    return size * sizeof(uint16_t);
+    free(listen_addr);
+    return found_count;
 }
 
 /**************************************************************************/
 /**
 *
-* @brief    Creates UDP socket
+* @brief    Checks if the given port is open, initializes address structure in case of success
 *
-* @param	sin_addr - IP address
 * @param	port_number - port number
-* @param	[out] server_addr - the structure describing an Internet socket address
+* @param	[out] tcp_server_addr - the structure describing an Internet socket address
 *
-* @return	Socket file descriptor
+* @return	0 if given port is found, otherwise -1
 *
-* @note		None
+* @note		To look up many ports use findOpenPorts, it reads /proc once for all of them.
+*
+**************************************************************************/
+int findOpenPort(unsigned int port_number, struct sockaddr_in *tcp_server_addr) {
+    uint16_t port = port_number;
+
+    if (port_number == 0 || port_number > 65535) {
+        return -1;
+    }
+    return (findOpenPorts(&port, 1, tcp_server_addr) == 1) ? 0 : -1;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Connects to the given port
+*
+* @param	tcp_server_addr - a pointer to the structure describing an Internet socket address
+* @param	timeout_ms - timeout for blocking read operation
+*
+* @return	file descriptor, -1 if the connection failed
+*
+* @note		Blocks until connected, the client apps use startConnect instead.
 *
 **************************************************************************/
-int startServer(struct in_addr *sin_addr, int port, struct sockaddr_in *server_addr) {
+int connectToPort(struct sockaddr_in *tcp_server_addr, int timeout_ms) {
     int sockfd;
 
     // Create socket
-    if ((sockfd = socket(AF_INET, SOCK_DGRAM, 0)) < 0) {
-        error_exit("UDP Socket creation failed");
+    if ((sockfd = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
+        error_exit("Socket creation failed");
+    }
+
+    // Connect to server
+    if (connect(sockfd, (struct sockaddr*)tcp_server_addr, sizeof(struct sockaddr_in)) < 0) {
+        perror("Connection failed");
+        close(sockfd);
+        return -1;
+    }
+
+    // Set read timeout
+    struct timeval timeout = {timeout_ms / 1000, (timeout_ms % 1000) * 1000};
+    if (setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) < 0) {
+        perror("Invalid socket options");
     }
 
-    server_addr->sin_family = AF_INET;
-    server_addr->sin_port = htons(port);
-    server_addr->sin_addr.s_addr = sin_addr->s_addr;
-    
     return sockfd;
 }
 
 /**************************************************************************/
 /**
 *
-* @brief    Sends message to the given port
+* @brief    Closes the socket of a managed port and schedules the next connect
 *
-* @param	sockfd - socket file descriptor
-* @param	server_addr - the structure describing an Internet socket address
-* @param	msg - a pointer to the message
-* @param	size - size of the message
+* @param	port - the port
+* @param	reason - printed if this is the first failure since the port was connected
 *
 * @return	None
 *
-* @note		Swaps byte order (Little-endian to Big-endian) before sending.
+* @note		The wait starts at RECONNECT_MIN_MS and doubles up to RECONNECT_MAX_MS.
 *
 **************************************************************************/
-void sendMessage(int sockfd, struct sockaddr_in *server_addr, uint16_t *msg, size_t size) {
-    uint16_t *buf = malloc(size);
-    if (buf == NULL) {
-        error_exit("Malloc failed");
+static void scheduleRetry(struct port_t *port, const char *reason) {
+    if (port->sockfd >= 0) {
+        close(port->sockfd);
+        port->sockfd = -1;
     }
+    port->state = PORT_DISCONNECTED;
 
-    // Swap byte order (Little-endian to Big-endian)
-    for (int i = 0; i < size / sizeof(uint16_t); ++i) {
-        buf[i] = ((msg[i] & 0x00FF) << 8) | ((msg[i] & 0xFF00) >> 8);
+    if (port->backoff_ms == 0) {
+        fprintf(stderr, "Port %u: %s, reconnecting\n", port->channel, reason);
+        port->backoff_ms = RECONNECT_MIN_MS;
+    } else if ((port->backoff_ms *= 2) > RECONNECT_MAX_MS) {
+        port->backoff_ms = RECONNECT_MAX_MS;
     }
+    port->retry_ns = monotonicNs() + port->backoff_ms * 1000000ull;
+}
 
-    int status = sendto(sockfd, (void *)buf, size, 0, (struct sockaddr *)server_addr, sizeof(struct sockaddr_in));
+/**************************************************************************/
+/**
+*
+* @brief    Enables software receive timestamps on the socket of a port
+*
+* @param	port - the port
+*
+* @return	0 on success, -1 if the kernel does not support them
+*
+* @note		The kernel stamps every received packet, readFromPort gets the stamp
+*           with the data from the same recvmsg call, no extra syscall is made.
+*
+**************************************************************************/
+int enableTimestamps(struct port_t *port) {
+    int flags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
 
-    free(buf);
-    if (status < 0) {
-        error_exit("Sendto failed");
-    }
+    port->timestamps = (setsockopt(port->sockfd, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) == 0);
+    return port->timestamps ? 0 : -1;
 }
 
 /**************************************************************************/
 /**
 *
-* @brief    Checks if the given port is open, initializes address structure in case of success
+* @brief    Starts a non-blocking connect of a managed port
 *
-* @param	port_number - port number
-* @param	[out] tcp_server_addr - the structure describing an Internet socket address
+* @param	port - the port, its endpoint is port->addr
 *
-* @return	0 if given port is found, otherwise -1
+* @return	0 if the port is connected or connecting, -1 if a retry is scheduled
 *
-* @note		None
+* @note		Never blocks, the event loop finishes the connect when the socket
+*           becomes writable, so all ports connect in parallel.
 *
 **************************************************************************/
-int findOpenPort(unsigned int port_number, struct sockaddr_in *tcp_server_addr) {
-    FILE *fp = fopen("/proc/net/tcp", "r");
-    int status = -1;
+int startConnect(struct port_t *port) {
+    if ((port->sockfd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) < 0) {
+        scheduleRetry(port, strerror(errno));
+        return -1;
+    }
 
-    if (!fp) {
-        error_exit("Unable to open /proc/net/tcp");
+    if (receive_timestamps) {
+        enableTimestamps(port);
     }
 
-    char line[256];
-    // Skip the first line (header)
-    fgets(line, sizeof(line), fp); 
+    if (connect(port->sockfd, (const struct sockaddr *)port->addr, sizeof(*port->addr)) == 0) {
+        port->state = PORT_CONNECTED;
+        port->backoff_ms = 0;
+        return 0;
+    }
+    if (errno == EINPROGRESS) {
+        port->state = PORT_CONNECTING;
+        return 0;
+    }
 
-    while (fgets(line, sizeof(line), fp)) {
-        unsigned int local_ip_hex, remote_ip_hex;
-        unsigned int local_port, remote_port;
-        unsigned int state;
+    scheduleRetry(port, strerror(errno));
+    return -1;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Checks the result of a non-blocking connect
+*
+* @param	port - the port, its socket became writable
+*
+* @return	0 if the port is connected, -1 if a retry is scheduled
+*
+**************************************************************************/
+int finishConnect(struct port_t *port) {
+    int error = 0;
+    socklen_t size = sizeof(error);
 
-        // Extract local and remote addresses, ports, and the connection state
-        sscanf(line, "%*d: %8X:%4X %8X:%4X %2X", &local_ip_hex, &local_port, &remote_ip_hex, &remote_port, &state);
+    if (getsockopt(port->sockfd, SOL_SOCKET, SO_ERROR, &error, &size) < 0) {
+        error = errno;
+    }
+    if (error != 0) {
+        scheduleRetry(port, strerror(error));
+        return -1;
+    }
 
-        // If port found and it is opened
-        if (local_port == port_number && state == 0x0a) {
-            // Set up server address structure
-            tcp_server_addr->sin_family = AF_INET;
-            tcp_server_addr->sin_port = htons(local_port);
-            tcp_server_addr->sin_addr.s_addr = htonl(local_ip_hex);
+    if (port->backoff_ms != 0) {
+        fprintf(stderr, "Port %u: reconnected\n", port->channel);
+    }
+    port->state = PORT_CONNECTED;
+    port->backoff_ms = 0;
+    return 0;
+}
 
-            status = 0;
-            break;
+/**************************************************************************/
+/**
+*
+* @brief    Handles a connection closed by the peer or failed
+*
+* @param	loop - event loop of the port
+* @param	index - index of the port in the loop
+*
+* @return	None
+*
+* @note		A managed port drops its partial line and is reconnected in the
+*           background, until then its channel has no new samples ("--"). Any
+*           other port is no longer watched.
+*
+**************************************************************************/
+void dropConnection(struct event_loop_t *loop, uint32_t index) {
+    struct port_t *port = &loop->ports[index];
+
+    if (port->stats != NULL) {
+        statsAdd(&port->stats->closed, 1);
+    }
+
+    if (port->addr == NULL) {
+        fprintf(stderr, "Port %u closed\n", index);
+        if (loop->uring == NULL) {
+            epoll_ctl(loop->epfd, EPOLL_CTL_DEL, port->sockfd, NULL);
         }
+        loop->active--;
+        return;
     }
 
-    fclose(fp);
-    return status;
+    port->head = port->tail;
+    clearPort(port);
+    scheduleRetry(port, "connection closed");
+    loop->waiting++;
 }
 
 /**************************************************************************/
 /**
 *
-* @brief    Connects to the given port
+* @brief    Adds the socket of a port to the event loop
 *
-* @param	tcp_server_addr - a pointer to the structure describing an Internet socket address
-* @param	timeout_ms - timeout for blocking read operation
+* @param	loop - event loop
+* @param	index - index of the port in the loop
 *
-* @return	file descriptor
+* @return	None
 *
-* @note		None
+* @note		A connecting socket is watched for writability, a connected one for data.
 *
 **************************************************************************/
-int connectToPort(struct sockaddr_in *tcp_server_addr, int timeout_ms) {
-    int sockfd;
+static void watchPort(struct event_loop_t *loop, uint32_t index) {
+    struct port_t *port = &loop->ports[index];
+    struct epoll_event ev;
 
-    // Create socket
-    if ((sockfd = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
-        error_exit("Socket creation failed");
+    if (loop->uring != NULL) {
+        watchUringPort(loop, index);
+        return;
     }
 
-    // Connect to server
-    if (connect(sockfd, (struct sockaddr*)tcp_server_addr, sizeof(struct sockaddr_in)) < 0) {
-        perror("Connection failed");
-        close(sockfd);
+    ev.events = ((port->state == PORT_CONNECTING) ? EPOLLOUT : EPOLLIN) | EPOLLRDHUP;
+    ev.data.u32 = index;
+    if (epoll_ctl(loop->epfd, EPOLL_CTL_ADD, port->sockfd, &ev) < 0) {
+        perror("Unable to watch port");
     }
+}
 
-    // Set read timeout to 10ms
-    struct timeval timeout = {0, timeout_ms};
-    if (setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) < 0) {
-        perror("Invalid socket options");
+/**************************************************************************/
+/**
+*
+* @brief    Starts the connects that are due and limits the wait until the next one
+*
+* @param	loop - event loop
+* @param	timeout_ms - maximum time to wait for events, -1 to wait forever
+*
+* @return	time to wait for events
+*
+* @note		Ports are only scanned while some of them are disconnected.
+*
+**************************************************************************/
+static int reconnectPorts(struct event_loop_t *loop, int timeout_ms) {
+    uint64_t now_ns, next_ns = UINT64_MAX;
+
+    if (loop->waiting == 0) {
+        return timeout_ms;
     }
 
-    return sockfd;
+    now_ns = monotonicNs();
+    for (int i = 0; i < loop->port_count; ++i) {
+        struct port_t *port = &loop->ports[i];
+
+        if (port->state != PORT_DISCONNECTED) {
+            continue;
+        }
+        if (port->retry_ns <= now_ns && startConnect(port) == 0) {
+            loop->waiting--;
+            watchPort(loop, i);
+            continue;
+        }
+        if (port->retry_ns < next_ns) {
+            next_ns = port->retry_ns;
+        }
+    }
+
+    if (next_ns == UINT64_MAX) {
+        return timeout_ms;
+    }
+    int retry_ms = (next_ns > now_ns) ? (int)((next_ns - now_ns + 999999) / 1000000) : 0;
+    return (timeout_ms < 0 || retry_ms < timeout_ms) ? retry_ms : timeout_ms;
 }
 
 /**************************************************************************/
 /**
 *
-* @brief    Reads data from the given port
+* @brief    Updates the signal estimate of a port with its last sample
 *
-* @param	port - contains the file descriptor and buffer for the given port
+* @param	port - port the sample was received from
 *
 * @return	None
 *
-* @note		None
+* @note		Results are published to the metrics of the port whenever a
+*           window ends. The kernel arrival time is used if available.
+*
+**************************************************************************/
+static void estimatePort(struct port_t *port) {
+    uint64_t time_ns = (port->timestamps && port->rx_ns != 0) ? port->rx_ns : port->recv_ns;
+    struct signal_estimator_t *estimator = &port->estimator;
+
+    if (estimateSignal(estimator, port->last.value, time_ns)) {
+        atomic_store_explicit(&port->stats->period_ns, estimator->period_ns, memory_order_relaxed);
+        atomic_store_explicit(&port->stats->amplitude, estimator->amplitude, memory_order_relaxed);
+        atomic_store_explicit(&port->stats->shape, estimator->shape, memory_order_relaxed);
+        atomic_store_explicit(&port->stats->periods, estimator->periods, memory_order_relaxed);
+    }
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Parses a single line and passes the sample to the port handler
+*
+* @param	port - port the line was received from
+* @param	start - a pointer to the line, not null-terminated
+* @param	size - size of the line without '\n'
+*
+* @return	None
+*
+* @note		Lines that are not valid values are dropped.
+*
+**************************************************************************/
+static void handleLine(struct port_t *port, const char *start, size_t size) {
+    if (size > 0 && start[size - 1] == '\r') {
+        size--;
+    }
+    if (size >= LINE_MAX_SIZE || parseSample(start, size, &port->last) < 0) {
+        return;
+    }
+    port->samples++;
+    if (port->stats != NULL) {
+        statsAdd(&port->stats->samples, 1);
+        estimatePort(port);
+    }
+    if (port->ring != NULL) {
+        publishRawSample(port->ring, port->channel, port->last, port->rx_ns);
+    }
+
+    if (port->on_sample != NULL) {
+        port->on_sample(port, port->last, port->ctx);
+    }
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Splits every complete line stored in the receive ring of the port
+*
+* @param	port - contains the receive ring for the given port
+*
+* @return	None
+*
+* @note		A partial line stays in the ring until the rest of it arrives.
 *
 **************************************************************************/
-void readFromPort(struct port_t *port) {
-    int bytes_received = recv(port->sockfd, port->buffer, sizeof(port->buffer) - 1, 0);
-    if (bytes_received > 0) {
-        // Replace '\n' with '\0'
-        port->buffer[bytes_received - 1] = '\0';
-        // Handle negative and positive values accordingly
-        if (bytes_received >= 5 && port->buffer[bytes_received - 5] == '-'){
-            port->data_ptr = &port->buffer[bytes_received - 5];
+static void splitLines(struct port_t *port) {
+    const uint32_t mask = BUFFER_SIZE - 1;
+
+    while (port->head != port->tail) {
+        char line[LINE_MAX_SIZE];
+        const char *start = &port->buffer[port->head & mask];
+        uint32_t avail = port->tail - port->head;
+        uint32_t chunk = BUFFER_SIZE - (port->head & mask);
+        size_t size;
+
+        if (chunk > avail) {
+            chunk = avail;
+        }
+
+        const char *end = memchr(start, '\n', chunk);
+        if (end != NULL) {
+            size = end - start;
+        } else if (chunk < avail) {
+            // The line wraps around the end of the ring
+            end = memchr(port->buffer, '\n', avail - chunk);
+            if (end == NULL) {
+                break;
+            }
+            size = chunk + (end - port->buffer);
+            port->head += size + 1;
+            if (size < sizeof(line)) {
+                memcpy(line, start, chunk);
+                memcpy(line + chunk, port->buffer, size - chunk);
+                handleLine(port, line, size);
+            }
+            continue;
         } else {
-            port->data_ptr = &port->buffer[bytes_received - 4];
+            break;
+        }
+
+        port->head += size + 1;
+        handleLine(port, start, size);
+    }
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Copies data into the receive ring of the port
+*
+* @param	port - contains the receive ring for the given port
+* @param	data - a pointer to the data
+* @param	size - size of the data
+*
+* @return	None
+*
+* @note		Data that does not fit into the ring is dropped.
+*
+**************************************************************************/
+static void appendToRing(struct port_t *port, const char *data, size_t size) {
+    const uint32_t mask = BUFFER_SIZE - 1;
+    uint32_t space = BUFFER_SIZE - (port->tail - port->head);
+    uint32_t pos = port->tail & mask;
+
+    if (size > space) {
+        size = space;
+    }
+
+    uint32_t first = (size < BUFFER_SIZE - pos) ? size : BUFFER_SIZE - pos;
+    memcpy(&port->buffer[pos], data, first);
+    memcpy(&port->buffer[0], data + first, size - first);
+    port->tail += size;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Reads data from the given port and splits it into lines
+*
+* @param	port - contains the file descriptor and receive ring for the given port
+*
+* @return	number of bytes received, 0 if the peer closed the connection, -1 on error
+*
+* @note		Every complete line is parsed and passed to the port handler, the last
+*           sample is kept until clearPort() is called. A partial line stays in the ring
+*           until the rest of it arrives. Nothing is allocated.
+*
+**************************************************************************/
+int readFromPort(struct port_t *port) {
+    const uint32_t mask = BUFFER_SIZE - 1;
+    uint32_t used = port->tail - port->head;
+    struct iovec iov[2];
+
+    // A full ring without a newline can never be framed, drop it
+    if (used == BUFFER_SIZE) {
+        port->head = port->tail;
+        used = 0;
+    }
+
+    // Fill both free segments of the ring with a single syscall
+    uint32_t pos = port->tail & mask;
+    uint32_t space = BUFFER_SIZE - used;
+    uint32_t first = (space < BUFFER_SIZE - pos) ? space : BUFFER_SIZE - pos;
+    iov[0].iov_base = &port->buffer[pos];
+    iov[0].iov_len = first;
+    iov[1].iov_base = &port->buffer[0];
+    iov[1].iov_len = space - first;
+
+    uint64_t start_ns = (port->stats != NULL) ? monotonicNs() : 0;
+    int bytes_received;
+    if (port->timestamps) {
+        // The kernel arrival time comes with the data as a control message
+        union {
+            char buffer[CMSG_SPACE(sizeof(struct scm_timestamping))];
+            struct cmsghdr align;
+        } control;
+        struct msghdr msg = {
+            .msg_iov = iov,
+            .msg_iovlen = (space > first) ? 2 : 1,
+            .msg_control = control.buffer,
+            .msg_controllen = sizeof(control.buffer)
+        };
+
+        bytes_received = recvmsg(port->sockfd, &msg, 0);
+        for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); bytes_received > 0 && cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPING) {
+                struct scm_timestamping stamp;
+                memcpy(&stamp, CMSG_DATA(cmsg), sizeof(stamp));
+                port->rx_ns = (uint64_t)stamp.ts[0].tv_sec * 1000000000ull + stamp.ts[0].tv_nsec;
+            }
         }
     } else {
-        // Set value as '--' if no data received
-        port->buffer[0] = port->buffer[1] = '-';
-        port->buffer[2] = '\0';
-        port->data_ptr = &port->buffer[0];
+        bytes_received = readv(port->sockfd, iov, (space > first) ? 2 : 1);
+    }
+    if (bytes_received <= 0) {
+        return bytes_received;
+    }
+    port->recv_ns = monotonicNs();
+    port->tail += bytes_received;
+
+    // Split every complete line in one pass
+    splitLines(port);
+
+    if (port->stats != NULL) {
+        statsAdd(&port->stats->bytes, bytes_received);
+        statsAdd(&port->stats->reads, 1);
+        statsRecord(&port->stats->read_ns, monotonicNs() - start_ns);
     }
+
+    return bytes_received;
 }
 
 /**************************************************************************/
 /**
 *
-* @brief    Reads data from the given port using separate thread
+* @brief    Splits data received into an external buffer into lines
 *
-* @param	args - contains the file descriptor and buffer for the given port
+* @param	port - contains the receive ring for the given port
+* @param	data - a pointer to the received data
+* @param	size - size of the data
 *
 * @return	None
 *
-* @note		None
+* @note		Complete lines are parsed in place, only a partial line is copied
+*           into the receive ring of the port.
 *
 **************************************************************************/
-void* readFromPortInThread(void *args) {
-    readFromPort((struct port_t *)args);
-    pthread_exit(NULL);
-}
\ No newline at end of file
+void consumeData(struct port_t *port, const char *data, size_t size) {
+    const char *end = data + size;
+
+    port->recv_ns = monotonicNs();
+    if (port->stats != NULL) {
+        statsAdd(&port->stats->bytes, size);
+        statsAdd(&port->stats->reads, 1);
+    }
+
+    // Complete the partial line left from the previous data first
+    if (port->head != port->tail) {
+        const char *newline = memchr(data, '\n', size);
+        if (newline == NULL) {
+            if (port->tail - port->head + size > BUFFER_SIZE) {
+                port->head = port->tail;
+            }
+            appendToRing(port, data, size);
+            return;
+        }
+        appendToRing(port, data, newline + 1 - data);
+        splitLines(port);
+        port->head = port->tail;
+        data = newline + 1;
+    }
+
+    while (data < end) {
+        const char *newline = memchr(data, '\n', end - data);
+        if (newline == NULL) {
+            appendToRing(port, data, end - data);
+            break;
+        }
+        handleLine(port, data, newline - data);
+        data = newline + 1;
+    }
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Marks the given port as having no data
+*
+* @param	port - contains the file descriptor and buffer for the given port
+*
+* @return	None
+*
+* @note		Value is set as '--' until new data is received.
+*
+**************************************************************************/
+void clearPort(struct port_t *port) {
+    port->last.valid = 0;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Parses a value in the server format (i.e. "-2.9") into fixed-point form
+*
+* @param	line - a pointer to the text, not null-terminated
+* @param	size - size of the text
+* @param	[out] sample - parsed value in tenths of a volt
+*
+* @return	0 on success, -1 if the text is not a valid value
+*
+* @note		Digits after the first fractional digit are ignored.
+*
+**************************************************************************/
+int parseSample(const char *line, size_t size, struct sample_t *sample) {
+    const char *end = line + size;
+    int32_t negative = (size > 0 && line[0] == '-');
+    int32_t value = 0;
+
+    line += negative;
+    if (line == end || end - line > 10 || (unsigned)(*line - '0') > 9) {
+        return -1;
+    }
+
+    // A longer integer part stops at a digit and is rejected below
+    const char *digits_end = (end - line > SAMPLE_INT_DIGITS) ? line + SAMPLE_INT_DIGITS : end;
+    while (line < digits_end && (unsigned)(*line - '0') <= 9) {
+        value = value * 10 + (*line++ - '0');
+    }
+    value *= 10;
+
+    if (line < end) {
+        if (*line != '.' || end - line < 2 || (unsigned)(line[1] - '0') > 9) {
+            return -1;
+        }
+        value += line[1] - '0';
+    }
+
+    // Conditional negation without a branch
+    sample->value = (value ^ -negative) + negative;
+    sample->valid = 1;
+    return 0;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Converts a sample into the server text format
+*
+* @param	sample - the value to convert
+* @param	[out] text - buffer of at least SAMPLE_TEXT_SIZE bytes
+*
+* @return	length of the text without the null terminator
+*
+* @note		Invalid samples are converted to "--".
+*
+**************************************************************************/
+int formatSample(struct sample_t sample, char *text) {
+    char digits[SAMPLE_TEXT_SIZE];
+    int length = 0, count = 0;
+
+    if (!sample.valid) {
+        memcpy(text, "--", 3);
+        return 2;
+    }
+
+    uint32_t value = (sample.value < 0) ? -(uint32_t)sample.value : (uint32_t)sample.value;
+
+    // Digits are produced in reverse order, the fractional one first
+    digits[count++] = '0' + value % 10;
+    digits[count++] = '.';
+    value /= 10;
+    do {
+        digits[count++] = '0' + value % 10;
+        value /= 10;
+    } while (value != 0);
+
+    if (sample.value < 0) {
+        text[length++] = '-';
+    }
+    while (count > 0) {
+        text[length++] = digits[--count];
+    }
+    text[length] = '\0';
+
+    return length;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Publishes the latest value into the slot (seqlock writer)
+*
+* @param	slot - slot of the port
+* @param	sample - the value to publish
+*
+* @return	None
+*
+* @note		Only one thread may write to a given slot.
+*
+**************************************************************************/
+void publishSample(struct sample_slot_t *slot, struct sample_t sample) {
+    uint32_t seq = atomic_load_explicit(&slot->seq, memory_order_relaxed);
+
+    atomic_store_explicit(&slot->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&slot->value, sample.value, memory_order_relaxed);
+    atomic_store_explicit(&slot->seq, seq + 2, memory_order_release);
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Takes a consistent copy of the latest value from the slot (seqlock reader)
+*
+* @param	slot - slot of the port
+* @param	[out] sample - the latest value, invalid if nothing was published yet
+*
+* @return	sequence number of the value, it changes whenever a new value is published
+*
+* @note		Never blocks the writer, retries only if a write was in progress.
+*
+**************************************************************************/
+uint32_t snapshotSample(struct sample_slot_t *slot, struct sample_t *sample) {
+    uint32_t seq;
+    int32_t value;
+
+    do {
+        seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        value = atomic_load_explicit(&slot->value, memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+    } while ((seq & 1) || seq != atomic_load_explicit(&slot->seq, memory_order_relaxed));
+
+    sample->value = value;
+    sample->valid = (seq != 0);
+    return seq;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Adds a sample to the running aggregates of its period (seqlock writer)
+*
+* @param	slot - aggregates of the port
+* @param	current - current output period, advanced by the tick
+* @param	sample - the received value
+*
+* @return	None
+*
+* @note		O(1) and without buffering, the half of a new period is reset by
+*           its first sample. Only one thread may write to a given slot. The
+*           period is read only after the half is marked as being written, so
+*           the tick either sees the write in progress or the writer sees the
+*           new period.
+*
+**************************************************************************/
+void aggregateSample(struct aggregate_slot_t *slot, _Atomic uint32_t *current, struct sample_t sample) {
+    uint32_t epoch = atomic_load_explicit(current, memory_order_relaxed);
+    struct aggregate_half_t *half;
+    uint32_t seq;
+
+    while (1) {
+        uint32_t guess = epoch;
+
+        half = &slot->half[guess & 1];
+        seq = atomic_load_explicit(&half->seq, memory_order_relaxed);
+        atomic_store_explicit(&half->seq, seq + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+
+        epoch = atomic_load_explicit(current, memory_order_relaxed);
+        if (((epoch ^ guess) & 1) == 0) {
+            break;
+        }
+        // The period was closed meanwhile, release the half untouched
+        atomic_store_explicit(&half->seq, seq + 2, memory_order_release);
+    }
+
+    if (atomic_load_explicit(&half->epoch, memory_order_relaxed) != epoch ||
+        atomic_load_explicit(&half->count, memory_order_relaxed) == 0) {
+        atomic_store_explicit(&half->epoch, epoch, memory_order_relaxed);
+        atomic_store_explicit(&half->min, sample.value, memory_order_relaxed);
+        atomic_store_explicit(&half->max, sample.value, memory_order_relaxed);
+        atomic_store_explicit(&half->count, 1, memory_order_relaxed);
+        atomic_store_explicit(&half->sum, sample.value, memory_order_relaxed);
+    } else {
+        if (sample.value < atomic_load_explicit(&half->min, memory_order_relaxed)) {
+            atomic_store_explicit(&half->min, sample.value, memory_order_relaxed);
+        }
+        if (sample.value > atomic_load_explicit(&half->max, memory_order_relaxed)) {
+            atomic_store_explicit(&half->max, sample.value, memory_order_relaxed);
+        }
+        atomic_store_explicit(&half->count, atomic_load_explicit(&half->count, memory_order_relaxed) + 1, memory_order_relaxed);
+        atomic_store_explicit(&half->sum, atomic_load_explicit(&half->sum, memory_order_relaxed) + sample.value, memory_order_relaxed);
+    }
+    atomic_store_explicit(&half->last, sample.value, memory_order_relaxed);
+
+    atomic_store_explicit(&half->seq, seq + 2, memory_order_release);
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Takes a consistent copy of the aggregates of a finished period (seqlock reader)
+*
+* @param	slot - aggregates of the port
+* @param	epoch - the finished period
+* @param	[out] aggregate - aggregates of the period, count is 0 if it had no samples
+*
+* @return	None
+*
+* @note		The period must already be closed, i.e. writers use a later epoch.
+*
+**************************************************************************/
+void takeAggregate(struct aggregate_slot_t *slot, uint32_t epoch, struct sample_aggregate_t *aggregate) {
+    struct aggregate_half_t *half = &slot->half[epoch & 1];
+    uint32_t seq;
+    uint32_t half_epoch;
+
+    do {
+        seq = atomic_load_explicit(&half->seq, memory_order_acquire);
+        half_epoch = atomic_load_explicit(&half->epoch, memory_order_relaxed);
+        aggregate->min = atomic_load_explicit(&half->min, memory_order_relaxed);
+        aggregate->max = atomic_load_explicit(&half->max, memory_order_relaxed);
+        aggregate->last = atomic_load_explicit(&half->last, memory_order_relaxed);
+        aggregate->count = atomic_load_explicit(&half->count, memory_order_relaxed);
+        aggregate->sum = atomic_load_explicit(&half->sum, memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+    } while ((seq & 1) || seq != atomic_load_explicit(&half->seq, memory_order_relaxed));
+
+    if (half_epoch != epoch) {
+        aggregate->count = 0;
+    }
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Classifies the shape of a signal from its value statistics
+*
+* @param	count - number of samples
+* @param	sum - sum of the samples
+* @param	sum_squares - sum of the squared samples
+* @param	min - smallest sample
+* @param	max - largest sample
+*
+* @return	shape of the signal
+*
+* @note		The RMS of a periodic signal relative to its half peak-to-peak
+*           value depends only on its shape.
+*
+**************************************************************************/
+enum signal_shape_e classifyShape(uint64_t count, int64_t sum, int64_t sum_squares, int32_t min, int32_t max) {
+    if (count == 0) {
+        return SIGNAL_UNKNOWN;
+    }
+    if (max == min) {
+        return SIGNAL_CONSTANT;
+    }
+
+    double half_range = (max - min) / 2.0;
+    double mean = (double)sum / count;
+    double variance = (double)sum_squares / count - mean * mean;
+    double ratio = sqrt(variance > 0 ? variance : 0) / half_range;
+
+    if (ratio > SQUARE_RATIO) {
+        return SIGNAL_SQUARE;
+    }
+    return (ratio > SINE_RATIO) ? SIGNAL_SINE : SIGNAL_TRIANGLE;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Gets the name of a shape
+*
+* @param	shape - the shape
+*
+* @return	name of the shape
+*
+* @note		None
+*
+**************************************************************************/
+const char* shapeName(enum signal_shape_e shape) {
+    switch (shape) {
+    case SIGNAL_CONSTANT:
+        return "constant";
+    case SIGNAL_SQUARE:
+        return "square";
+    case SIGNAL_SINE:
+        return "sine";
+    case SIGNAL_TRIANGLE:
+        return "triangle";
+    default:
+        return "unknown";
+    }
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Adds a sample to the streaming estimate of the period, amplitude and shape
+*
+* @param	estimator - estimator of the signal, zeroed before the first sample
+* @param	value - the sample, tenths of a volt
+* @param	time_ns - arrival time of the sample
+*
+* @return	1 if a window ended and the results were updated, otherwise 0
+*
+* @note		A window spans one period, from an upward crossing of the midline
+*           to the next one (with hysteresis, and a few samples in a row so
+*           single glitches are ignored). Its range and moments give the
+*           amplitude and shape, and the midline of the next window, so changes
+*           of frequency or amplitude show up after a single period. A window
+*           without a rise for several periods ends as a signal that does not
+*           oscillate. Only integer arithmetic is done per sample.
+*
+**************************************************************************/
+int estimateSignal(struct signal_estimator_t *estimator, int32_t value, uint64_t time_ns) {
+    struct signal_estimator_t *e = estimator;
+    uint64_t limit_ns = e->period_ns ? e->period_ns * ESTIMATOR_STALE_PERIODS : ESTIMATOR_MAX_PERIOD_NS;
+    int result = 0;
+
+    if (e->count > 0 && time_ns - e->start_ns > limit_ns) {
+        e->period_ns = 0;
+        e->amplitude = (e->max > -e->min) ? e->max : -e->min;
+        e->shape = (e->max == e->min) ? SIGNAL_CONSTANT : SIGNAL_UNKNOWN;
+        e->count = 0;
+        e->locked = 0;
+        result = 1;
+    }
+
+    if (e->count++ == 0) {
+        e->min = e->max = value;
+        e->sum = e->sum_squares = 0;
+        e->start_ns = time_ns;
+    } else if (value < e->min) {
+        e->min = value;
+    } else if (value > e->max) {
+        e->max = value;
+    }
+    e->sum += value;
+    e->sum_squares += (int64_t)value * value;
+
+    // Until a full period is seen the midline follows the range of the window
+    if (!e->locked) {
+        int32_t span = (e->max - e->min) / ESTIMATOR_HYSTERESIS_DIVIDER;
+        e->mid = e->min + (e->max - e->min) / 2;
+        e->hysteresis = (span > ESTIMATOR_HYSTERESIS) ? span : ESTIMATOR_HYSTERESIS;
+    }
+
+    int32_t side = (value > e->mid + e->hysteresis) ? 1 : (value < e->mid - e->hysteresis) ? -1 : 0;
+    if (side == 0 || side == e->state) {
+        e->run = 0;
+    } else if (++e->run >= ESTIMATOR_DEBOUNCE || e->state == 0) {
+        if (side > 0 && e->state < 0) {
+            if (e->locked) {
+                // The rise belongs to the next window, the finished one ends before it
+                int32_t span;
+
+                e->sum -= value;
+                e->sum_squares -= (int64_t)value * value;
+                e->count--;
+                e->period_ns = time_ns - e->start_ns;
+                e->amplitude = (e->max > -e->min) ? e->max : -e->min;
+                e->shape = classifyShape(e->count, e->sum, e->sum_squares, e->min, e->max);
+                e->periods++;
+                span = (e->max - e->min) / ESTIMATOR_HYSTERESIS_DIVIDER;
+                e->mid = e->min + (e->max - e->min) / 2;
+                e->hysteresis = (span > ESTIMATOR_HYSTERESIS) ? span : ESTIMATOR_HYSTERESIS;
+                result = 1;
+            }
+            e->locked = 1;
+            e->count = 1;
+            e->min = e->max = value;
+            e->sum = value;
+            e->sum_squares = (int64_t)value * value;
+            e->start_ns = time_ns;
+        }
+        e->state = side;
+        e->run = 0;
+    }
+
+    return result;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Creates an event loop over the given ports and a periodic tick timer
+*
+* @param	[out] loop - event loop to initialize
+* @param	ports - ports to watch, sockets are switched to non-blocking mode
+* @param	port_count - number of ports
+* @param	tick_ms - tick period in milliseconds, 0 to watch the ports only
+*
+* @return	0 on success, otherwise -1
+*
+* @note		None
+*
+**************************************************************************/
+int initEventLoop(struct event_loop_t *loop, struct port_t *ports, int port_count, unsigned long tick_ms) {
+    struct epoll_event ev;
+    struct itimerspec tick;
+
+    loop->ports = ports;
+    loop->port_count = port_count;
+    loop->active = port_count;
+    loop->waiting = 0;
+    loop->period_ns = tick_ms * 1000000ull;
+    loop->deadline_ns = 0;
+    loop->timerfd = -1;
+    loop->uring = NULL;
+
+    if ((loop->epfd = epoll_create1(EPOLL_CLOEXEC)) < 0) {
+        return -1;
+    }
+
+    if (tick_ms > 0 && (loop->timerfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)) < 0) {
+        closeEventLoop(loop);
+        return -1;
+    }
+
+    for (int i = 0; i < port_count; ++i) {
+        clearPort(&ports[i]);
+        if (ports[i].state == PORT_DISCONNECTED) {
+            loop->waiting++;
+        }
+    }
+
+    // Prefer io_uring if it is built in and supported by the kernel, otherwise use epoll.
+    // Multishot recv does not return control messages, so kernel timestamps need epoll.
+    if (event_backend != BACKEND_IO_URING || receive_timestamps || initUring(loop) < 0) {
+        if (loop->timerfd >= 0) {
+            // The timer is registered with index port_count, sockets with their own index
+            ev.events = EPOLLIN;
+            ev.data.u32 = port_count;
+            if (epoll_ctl(loop->epfd, EPOLL_CTL_ADD, loop->timerfd, &ev) < 0) {
+                closeEventLoop(loop);
+                return -1;
+            }
+        }
+
+        for (int i = 0; i < port_count; ++i) {
+            if (ports[i].state == PORT_DISCONNECTED) {
+                continue;
+            }
+            fcntl(ports[i].sockfd, F_SETFL, fcntl(ports[i].sockfd, F_GETFL) | O_NONBLOCK);
+            watchPort(loop, i);
+        }
+    }
+
+    // Ticks are absolute deadlines on CLOCK_MONOTONIC, a late wakeup does not move the later ones
+    if (loop->timerfd >= 0) {
+        loop->deadline_ns = monotonicNs() + loop->period_ns;
+        tick.it_interval = (struct timespec){loop->period_ns / 1000000000, loop->period_ns % 1000000000};
+        tick.it_value = (struct timespec){loop->deadline_ns / 1000000000, loop->deadline_ns % 1000000000};
+        if (timerfd_settime(loop->timerfd, TFD_TIMER_ABSTIME, &tick, NULL) < 0) {
+            closeEventLoop(loop);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Waits for events and consumes data from the ports that have it
+*
+* @param	loop - event loop
+* @param	timeout_ms - maximum time to wait, -1 to wait forever
+*
+* @return	number of tick periods elapsed, 0 if the timer has not expired
+*
+* @note		Lost connections of managed ports are retried here, the wait is cut
+*           short when a retry is due.
+*
+**************************************************************************/
+uint64_t dispatchEvents(struct event_loop_t *loop, int timeout_ms) {
+    struct epoll_event events[EVENT_BATCH];
+    uint64_t expirations = 0;
+
+    timeout_ms = reconnectPorts(loop, timeout_ms);
+    if (loop->uring != NULL) {
+        return dispatchUring(loop, timeout_ms);
+    }
+
+    int count = epoll_wait(loop->epfd, events, EVENT_BATCH, timeout_ms);
+    if (count < 0) {
+        if (errno == EINTR) {
+            return 0;
+        }
+        error_exit("Epoll wait failed");
+    }
+
+    for (int i = 0; i < count; ++i) {
+        uint32_t index = events[i].data.u32;
+
+        if (index == (uint32_t)loop->port_count) {
+            if (read(loop->timerfd, &expirations, sizeof(expirations)) < 0) {
+                expirations = 0;
+            }
+            continue;
+        }
+
+        struct port_t *port = &loop->ports[index];
+        if (port->state == PORT_CONNECTING) {
+            struct epoll_event ev = {.events = EPOLLIN | EPOLLRDHUP, .data.u32 = index};
+            if (finishConnect(port) < 0) {
+                loop->waiting++;
+            } else {
+                epoll_ctl(loop->epfd, EPOLL_CTL_MOD, port->sockfd, &ev);
+            }
+            continue;
+        }
+
+        // A hang-up without data left to read is a closed connection too
+        int status = readFromPort(port);
+        if (status == 0 || (status < 0 && ((errno != EAGAIN && errno != EWOULDBLOCK) ||
+                                           (events[i].events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR))))) {
+            dropConnection(loop, index);
+        }
+    }
+
+    return expirations;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Consumes data from the ports as it arrives until the next tick
+*
+* @param	loop - event loop
+*
+* @return	number of tick periods elapsed since the previous call, more than 1
+*           if ticks were missed
+*
+* @note		Blocks in epoll_wait between events, so no CPU is used while idle.
+*           The delay behind the deadline of the tick is recorded in the metrics.
+*
+**************************************************************************/
+uint64_t waitForTick(struct event_loop_t *loop) {
+    uint64_t expirations;
+
+    while ((expirations = dispatchEvents(loop, -1)) == 0) {
+    }
+
+    // Deadline of the latest expired tick, the ones before it were missed
+    uint64_t deadline_ns = loop->deadline_ns + (expirations - 1) * loop->period_ns;
+    recordTickLag(monotonicNs() - deadline_ns);
+    loop->deadline_ns = deadline_ns + loop->period_ns;
+
+    return expirations;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Switches the calling thread to low-jitter mode
+*
+* @param	cpu - CPU the thread is pinned to
+*
+* @return	0 on success, -1 if any of the settings could not be applied
+*
+* @note		Pins the thread, locks all current and future memory, prefaults the
+*           stack and sets SCHED_FIFO. Threads started later inherit the policy
+*           and the CPU, so this is called after the readers are started. A setting
+*           that fails (i.e. without CAP_SYS_NICE or CAP_IPC_LOCK) is reported
+*           and the others stay in effect.
+*
+**************************************************************************/
+int enableRealtime(int cpu) {
+    struct sched_param param = {.sched_priority = REALTIME_PRIORITY};
+    volatile char stack[STACK_PREFAULT];
+    cpu_set_t set;
+    int status = 0, error;
+
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if ((error = pthread_setaffinity_np(pthread_self(), sizeof(set), &set)) != 0) {
+        fprintf(stderr, "Unable to pin the tick thread to CPU %d: %s\n", cpu, strerror(error));
+        status = -1;
+    }
+
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) < 0) {
+        perror("Unable to lock memory");
+        status = -1;
+    }
+    for (size_t i = 0; i < sizeof(stack); i += 4096) {
+        stack[i] = 0;
+    }
+
+    if ((error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param)) != 0) {
+        fprintf(stderr, "Unable to set SCHED_FIFO: %s\n", strerror(error));
+        status = -1;
+    }
+
+    return status;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Reads data from the ports of the given event loop in a separate thread
+*
+* @param	args - event loop created without a tick timer
+*
+* @return	None
+*
+* @note		Runs until all ports of the loop are closed.
+*
+**************************************************************************/
+void* readFromPortsInThread(void *args) {
+    struct event_loop_t *loop = (struct event_loop_t *)args;
+
+    while (loop->active > 0) {
+        dispatchEvents(loop, -1);
+    }
+
+    pthread_exit(NULL);
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Releases the event loop resources
+*
+* @param	loop - event loop
+*
+* @return	None
+*
+* @note		Port sockets are not closed.
+*
+**************************************************************************/
+void closeEventLoop(struct event_loop_t *loop) {
+    closeUring(loop);
+    if (loop->timerfd >= 0) {
+        close(loop->timerfd);
+    }
+    close(loop->epfd);
+}
@@ -20,20 +20,159 @@
 #include <sys/time.h>
 #include <pthread.h>
 #include <stdint.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/uio.h>
+#include <sys/socket.h>
+#include <linux/net_tstamp.h>
+#include <linux/errqueue.h>
 
 /************************** Constant Definitions *****************************/
 
-#define BUFFER_SIZE     1024
-#define MAX_PORTS       3
+#define BUFFER_SIZE     1024    // Size of the receive ring buffer, must be a power of two
+#define LINE_MAX_SIZE   32      // Longest line accepted from a port
+#define SAMPLE_TEXT_SIZE 16     // Buffer size for the text form of a sample
+#define SAMPLE_INT_DIGITS 8     // Longest integer part of a sample, tenths of it fit in int32_t
+#define EVENT_BATCH     64      // Events handled per epoll_wait call
+#define MAX_PORTS       3       // Number of outputs of the signal server
 #define TCP_PORT        4001
 #define UDP_PORT        4000
+#define RECONNECT_MIN_MS 100    // First retry of a lost connection
+#define RECONNECT_MAX_MS 5000   // Longest time between retries, the wait doubles up to it
+#define REALTIME_PRIORITY 50    // SCHED_FIFO priority of the tick thread in realtime mode
+#define STACK_PREFAULT  (256 * 1024)    // Stack touched in realtime mode so it never faults later
+#define ESTIMATOR_HYSTERESIS    2       // Tenths of a volt around the midline ignored by the crossing detector
+#define ESTIMATOR_HYSTERESIS_DIVIDER 10 // Hysteresis is at least this fraction of the peak-to-peak value
+#define ESTIMATOR_DEBOUNCE      3       // Samples in a row past the dead band that move the signal to the other side
+#define ESTIMATOR_STALE_PERIODS 4       // A signal without a rise for this many periods no longer oscillates
+#define ESTIMATOR_MAX_PERIOD_NS 60000000000ull  // Longest period measured before the first one is known
+#define SQUARE_RATIO            0.85    // RMS / half peak-to-peak: square 1.0, sine 0.707, triangle 0.577
+#define SINE_RATIO              0.64
 
 /**************************** Type Definitions *******************************/
 
+// Value received from a port in fixed-point form
+struct sample_t {
+    int32_t value;              // tenths of a volt, i.e. "-2.9" is -29
+    int32_t valid;              // 0 if no value was received (printed as "--")
+};
+
+// Latest value of a port, written by a single reader thread and read by the tick without locks
+struct sample_slot_t {
+    _Atomic uint32_t seq;       // odd while a write is in progress, advances by 2 per sample
+    _Atomic int32_t value;      // tenths of a volt
+};
+
+// Running aggregates of the samples of a port within one output period
+struct sample_aggregate_t {
+    int32_t min;                // tenths of a volt
+    int32_t max;
+    int32_t last;
+    uint32_t count;             // 0 if no sample was received in the period
+    int64_t sum;
+};
+
+// Aggregates of one period, written by a single reader thread and read by the tick without locks
+struct aggregate_half_t {
+    _Atomic uint32_t seq;       // odd while an update is in progress
+    _Atomic uint32_t epoch;     // period the half is accumulating
+    _Atomic int32_t min;
+    _Atomic int32_t max;
+    _Atomic int32_t last;
+    _Atomic uint32_t count;
+    _Atomic int64_t sum;
+};
+
+// Aggregates of a port, one half per period parity so the tick reads a closed period
+struct aggregate_slot_t {
+    struct aggregate_half_t half[2];
+};
+
+// Connection state of a port
+enum port_state_e {
+    PORT_CONNECTED = 0,
+    PORT_CONNECTING,            // non-blocking connect in progress
+    PORT_DISCONNECTED           // no socket, waiting for the next retry
+};
+
+// Waveform classified from the RMS relative to the half peak-to-peak value
+enum signal_shape_e {
+    SIGNAL_UNKNOWN = 0,
+    SIGNAL_CONSTANT,
+    SIGNAL_SQUARE,
+    SIGNAL_SINE,
+    SIGNAL_TRIANGLE
+};
+
+// Streaming estimate of the period, amplitude and shape of a signal, constant memory and O(1) per sample
+struct signal_estimator_t {
+    int32_t min;                // range of the current window
+    int32_t max;
+    int64_t sum;
+    int64_t sum_squares;
+    uint32_t count;             // samples in the current window, 0 to start a new one
+    int32_t state;              // side of the midline the signal is on, 0 before the first sample
+    uint32_t run;               // samples in a row on the other side, single glitches don't cross
+    int32_t mid;                // midline and dead band, taken from the previous period
+    int32_t hysteresis;
+    uint32_t locked;            // the window started at a rise, so it ends with a full period
+    uint64_t start_ns;          // time of the first sample (or the rise) of the window
+    uint64_t period_ns;         // results of the last window, period_ns is 0 if the signal does not oscillate
+    int32_t amplitude;          // largest absolute value, tenths of a volt
+    uint32_t shape;             // enum signal_shape_e
+    uint64_t periods;           // full periods measured
+};
+
+struct port_t;
+struct port_stats_t;
+struct shm_ring_t;
+
+// Called for every sample received from a port
+typedef void (*sample_handler_t)(struct port_t *port, struct sample_t sample, void *ctx);
+
 struct port_t {
     int sockfd;
-    char *data_ptr;
-    char buffer[BUFFER_SIZE];
+    uint32_t head;              // ring read position, free-running
+    uint32_t tail;              // ring write position, free-running
+    uint64_t samples;           // number of samples received
+    sample_handler_t on_sample; // optional handler for every sample
+    void *ctx;                  // context passed to the handler
+    struct sample_t last;       // last received sample
+    struct port_stats_t *stats; // metrics of the port, NULL if disabled
+    struct shm_ring_t *ring;    // ring every sample is published to, NULL if not published
+    uint32_t channel;           // index of the channel in the client
+    uint64_t recv_ns;           // monotonic time the data being framed was received
+    uint64_t rx_ns;             // CLOCK_REALTIME kernel arrival time of that data, 0 without timestamps
+    int timestamps;             // kernel receive timestamps are enabled on the socket
+    const struct sockaddr_in *addr; // endpoint to reconnect to, NULL if the connection is not managed
+    uint32_t state;             // enum port_state_e
+    uint32_t backoff_ms;        // wait before the next retry, 0 while connected
+    uint64_t retry_ns;          // monotonic time of the next retry
+    struct signal_estimator_t estimator;    // updated for every sample if metrics are enabled
+    char buffer[BUFFER_SIZE];   // receive ring, holds partial lines between reads
+};
+
+// Receive backend of the event loop
+enum backend_e {
+    BACKEND_EPOLL = 0,
+    BACKEND_IO_URING = 1        // used only if built with URING=1 and supported by the kernel
+};
+
+struct uring_t;
+
+struct event_loop_t {
+    struct uring_t *uring;      // io_uring backend, NULL if epoll is used
+    int epfd;                   // epoll set with all port sockets and the tick timer
+    int timerfd;                // periodic tick timer
+    struct port_t *ports;
+    int port_count;
+    int active;                 // number of ports still watched
+    int waiting;                // managed ports waiting for a reconnect
+    uint64_t period_ns;         // tick period
+    uint64_t deadline_ns;       // CLOCK_MONOTONIC deadline of the next tick
 };
 
 /************************** Function Prototypes ******************************/
@@ -41,16 +180,37 @@ struct port_t {
 void error_exit(const char *msg);
 
 int findOpenPort(unsigned int port_number, struct sockaddr_in *tcp_server_addr);
+size_t findOpenPorts(const uint16_t *ports, size_t count, struct sockaddr_in *tcp_server_addr);
 int connectToPort(struct sockaddr_in *tcp_server_addr, int timeout_ms);
-void readFromPort(struct port_t *port);
-void* readFromPortInThread(void *args);
+int startConnect(struct port_t *port);
+int finishConnect(struct port_t *port);
+int enableTimestamps(struct port_t *port);
+void dropConnection(struct event_loop_t *loop, uint32_t index);
+int readFromPort(struct port_t *port);
+void consumeData(struct port_t *port, const char *data, size_t size);
+void clearPort(struct port_t *port);
+
+int parseSample(const char *line, size_t size, struct sample_t *sample);
+int formatSample(struct sample_t sample, char *text);
+void publishSample(struct sample_slot_t *slot, struct sample_t sample);
+uint32_t snapshotSample(struct sample_slot_t *slot, struct sample_t *sample);
+void aggregateSample(struct aggregate_slot_t *slot, _Atomic uint32_t *current, struct sample_t sample);
+void takeAggregate(struct aggregate_slot_t *slot, uint32_t epoch, struct sample_aggregate_t *aggregate);
+int estimateSignal(struct signal_estimator_t *estimator, int32_t value, uint64_t time_ns);
+enum signal_shape_e classifyShape(uint64_t count, int64_t sum, int64_t sum_squares, int32_t min, int32_t max);
+const char* shapeName(enum signal_shape_e shape);
 
-int startServer(struct in_addr *sin_addr, int port, struct sockaddr_in *server_addr);
-void sendMessage(int sockfd, struct sockaddr_in *server_addr, uint16_t *msg, size_t size);
-void changeBehavior(char *data, int udp_sokfd, struct sockaddr_in *udp_server_addr);
+int initEventLoop(struct event_loop_t *loop, struct port_t *ports, int port_count, unsigned long tick_ms);
+uint64_t dispatchEvents(struct event_loop_t *loop, int timeout_ms);
+uint64_t waitForTick(struct event_loop_t *loop);
+int enableRealtime(int cpu);
+void* readFromPortsInThread(void *args);
+void closeEventLoop(struct event_loop_t *loop);
 
 /************************** Variable Definitions *****************************/
 
+extern enum backend_e event_backend;    // backend preferred by new event loops
+extern int receive_timestamps;          // enable kernel receive timestamps on new connections
 
 
 #endif /* __CLIENT_LIB_H__ */
\ No newline at end of file
@@ -0,0 +1,357 @@
+/*****************************************************************************/
+/**
+*  Brief: 	Contains implementation of the UDP control path.
+*
+*  Created: 16.10.2026
+*  Author: 	Yurii Shenbor
+*
+******************************************************************************/
+
+/***************************** Include Files ********************************/
+
+#define _GNU_SOURCE     // sendmmsg
+
+#include "control.h"
+#include "stats.h"
+
+/************************** Constant Definitions *****************************/
+
+static const struct {
+    const char *name;
+    enum property_e property;
+} property_names[] = {
+    {"enabled", ENABLED},
+    {"min_duration", MIN_DURATION},
+    {"max_duration", MAX_DURATION},
+    {"amplitude", AMPLITUDE},
+    {"frequency", FREQUENCY},
+    {"glitch_chance", GLITCH_CHANCE},
+};
+
+/************************** Function Prototypes ******************************/
+
+static void addPending(struct control_t *ctl, const struct control_msg_t *msg, uint64_t sent_ns);
+static void removePending(struct control_t *ctl, unsigned index);
+
+/**************************************************************************/
+/**
+*
+* @brief    Creates UDP socket
+*
+* @param	sin_addr - IP address
+* @param	port_number - port number
+* @param	[out] server_addr - the structure describing an Internet socket address
+*
+* @return	Socket file descriptor
+*
+* @note		None
+*
+**************************************************************************/
+int startServer(struct in_addr *sin_addr, int port, struct sockaddr_in *server_addr) {
+    int sockfd;
+
+    // Create socket
+    if ((sockfd = socket(AF_INET, SOCK_DGRAM, 0)) < 0) {
+        error_exit("UDP Socket creation failed");
+    }
+
+    server_addr->sin_family = AF_INET;
+    server_addr->sin_port = htons(port);
+    server_addr->sin_addr.s_addr = sin_addr->s_addr;
+    
+    return sockfd;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Creates the control socket for a server
+*
+* @param	[out] ctl - control state
+* @param	sin_addr - IP address of the server
+* @param	port - UDP port of the server
+* @param	ack - read every written property back and report the result
+*
+* @return	0 on success, otherwise -1
+*
+* @note		None
+*
+**************************************************************************/
+int initControl(struct control_t *ctl, struct in_addr *sin_addr, int port, int ack) {
+    memset(ctl, 0, sizeof(*ctl));
+    ctl->sockfd = startServer(sin_addr, port, &ctl->addr);
+    ctl->ack = ack;
+    return (ctl->sockfd < 0) ? -1 : 0;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Closes the control socket
+*
+* @param	ctl - control state
+*
+* @return	None
+*
+* @note		None
+*
+**************************************************************************/
+void closeControl(struct control_t *ctl) {
+    if (ctl->sockfd >= 0) {
+        close(ctl->sockfd);
+    }
+    ctl->sockfd = -1;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Encodes a message in wire format
+*
+* @param	op - operation
+* @param	obj - object
+* @param	prop - property
+* @param	val - value for write opperations
+* @param	[out] msg - the message
+*
+* @return	None
+*
+* @note		Rule writes are encoded once when the rules are loaded.
+*
+**************************************************************************/
+void encodeMessage(enum operation_e op, enum object_e obj, enum property_e prop, uint16_t val, struct control_msg_t *msg) {
+    const uint16_t fields[] = {op, obj, prop, val};
+
+    msg->size = (op == WRITE) ? 8 : 6;
+    for (int i = 0; i < msg->size / 2; ++i) {
+        msg->data[i * 2] = fields[i] >> 8;
+        msg->data[i * 2 + 1] = fields[i] & 0xFF;
+    }
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Looks up a property by its name
+*
+* @param	name - name of the property, i.e. "frequency"
+*
+* @return	the property, -1 if the name is unknown
+*
+* @note		None
+*
+**************************************************************************/
+int findProperty(const char *name) {
+    for (size_t i = 0; i < sizeof(property_names) / sizeof(property_names[0]); ++i) {
+        if (strcmp(name, property_names[i].name) == 0) {
+            return property_names[i].property;
+        }
+    }
+    return -1;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Gets the name of a property
+*
+* @param	property - the property
+*
+* @return	name of the property, NULL if it is unknown
+*
+* @note		None
+*
+**************************************************************************/
+const char* propertyName(uint16_t property) {
+    for (size_t i = 0; i < sizeof(property_names) / sizeof(property_names[0]); ++i) {
+        if (property == property_names[i].property) {
+            return property_names[i].name;
+        }
+    }
+    return NULL;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Remembers a write that waits for its read-back
+*
+* @param	ctl - control state
+* @param	msg - the write message
+* @param	sent_ns - monotonic time the write was sent
+*
+* @return	None
+*
+* @note		If too many writes wait, the oldest one is reported as not confirmed.
+*
+**************************************************************************/
+static void addPending(struct control_t *ctl, const struct control_msg_t *msg, uint64_t sent_ns) {
+    if (ctl->pending_count == CONTROL_PENDING_MAX) {
+        ctl->timeouts++;
+        recordAck(0, ACK_TIMEOUT);
+        removePending(ctl, 0);
+    }
+
+    struct control_pending_t *pending = &ctl->pending[ctl->pending_count++];
+    pending->object = (msg->data[2] << 8) | msg->data[3];
+    pending->property = (msg->data[4] << 8) | msg->data[5];
+    pending->value = (msg->data[6] << 8) | msg->data[7];
+    pending->sent_ns = sent_ns;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Forgets a write that waited for its read-back
+*
+* @param	ctl - control state
+* @param	index - index of the write
+*
+* @return	None
+*
+* @note		The order of the remaining writes is kept.
+*
+**************************************************************************/
+static void removePending(struct control_t *ctl, unsigned index) {
+    ctl->pending_count--;
+    memmove(&ctl->pending[index], &ctl->pending[index + 1], (ctl->pending_count - index) * sizeof(ctl->pending[0]));
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Sends related messages with a single syscall
+*
+* @param	ctl - control state
+* @param	msgs - messages in wire format
+* @param	count - number of messages, up to CONTROL_BATCH_MAX
+*
+* @return	number of messages sent, -1 if the batch could not be sent
+*
+* @note		In read-back mode a READ of every written property is added to the
+*           same batch, the replies are handled by pollAcks.
+*
+**************************************************************************/
+int sendMessages(struct control_t *ctl, const struct control_msg_t *msgs, unsigned count) {
+    struct mmsghdr headers[CONTROL_BATCH_MAX * 2];
+    struct iovec iov[CONTROL_BATCH_MAX * 2];
+    struct control_msg_t reads[CONTROL_BATCH_MAX];
+    unsigned total = 0;
+
+    if (count > CONTROL_BATCH_MAX) {
+        count = CONTROL_BATCH_MAX;
+    }
+
+    for (unsigned i = 0; i < count; ++i) {
+        iov[total] = (struct iovec){(void *)msgs[i].data, msgs[i].size};
+        total++;
+    }
+    if (ctl->ack) {
+        for (unsigned i = 0; i < count; ++i) {
+            if (msgs[i].size == 8 && msgs[i].data[1] == WRITE) {
+                reads[i] = msgs[i];
+                reads[i].size = 6;
+                reads[i].data[1] = READ;
+                iov[total] = (struct iovec){reads[i].data, reads[i].size};
+                total++;
+            }
+        }
+    }
+
+    memset(headers, 0, total * sizeof(headers[0]));
+    for (unsigned i = 0; i < total; ++i) {
+        headers[i].msg_hdr.msg_name = &ctl->addr;
+        headers[i].msg_hdr.msg_namelen = sizeof(ctl->addr);
+        headers[i].msg_hdr.msg_iov = &iov[i];
+        headers[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    uint64_t start_ns = monotonicNs();
+    unsigned sent = 0;
+    while (sent < total) {
+        int status = sendmmsg(ctl->sockfd, &headers[sent], total - sent, 0);
+        if (status < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        sent += status;
+    }
+
+    for (unsigned i = 0; i < count; ++i) {
+        recordSend(start_ns, i >= sent);
+    }
+    if (sent < count) {
+        perror("Sendmmsg failed");
+        return -1;
+    }
+
+    // Writes whose read-back went out as well wait for the reply
+    for (unsigned i = 0, read = count; ctl->ack && i < count && read < sent; ++i) {
+        if (msgs[i].size == 8 && msgs[i].data[1] == WRITE) {
+            addPending(ctl, &msgs[i], start_ns);
+            read++;
+        }
+    }
+
+    return count;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Handles read-back replies and reports writes that were not confirmed
+*
+* @param	ctl - control state
+*
+* @return	None
+*
+* @note		Never blocks, meant to be called on every tick.
+*
+**************************************************************************/
+void pollAcks(struct control_t *ctl) {
+    uint8_t reply[16];
+    ssize_t size;
+
+    if (!ctl->ack || ctl->pending_count == 0) {
+        return;
+    }
+
+    while ((size = recv(ctl->sockfd, reply, sizeof(reply), MSG_DONTWAIT)) >= 0) {
+        if (size < 8 || reply[1] != READ) {
+            continue;
+        }
+
+        uint16_t object = (reply[2] << 8) | reply[3];
+        uint16_t property = (reply[4] << 8) | reply[5];
+        uint16_t value = (reply[6] << 8) | reply[7];
+
+        for (unsigned i = 0; i < ctl->pending_count; ++i) {
+            struct control_pending_t *pending = &ctl->pending[i];
+            if (pending->object != object || pending->property != property) {
+                continue;
+            }
+
+            uint64_t rtt_ns = monotonicNs() - pending->sent_ns;
+            if (pending->value == value) {
+                ctl->acks++;
+                recordAck(rtt_ns, ACK_CONFIRMED);
+            } else {
+                ctl->mismatches++;
+                recordAck(rtt_ns, ACK_MISMATCH);
+                fprintf(stderr, "Control write %u.%u=%u read back as %u\n", object, property, pending->value, value);
+            }
+            removePending(ctl, i);
+            break;
+        }
+    }
+
+    uint64_t now_ns = monotonicNs();
+    while (ctl->pending_count > 0 && now_ns - ctl->pending[0].sent_ns > CONTROL_ACK_TIMEOUT_MS * 1000000ull) {
+        fprintf(stderr, "Control write %u.%u=%u not confirmed\n", ctl->pending[0].object, ctl->pending[0].property, ctl->pending[0].value);
+        ctl->timeouts++;
+        recordAck(0, ACK_TIMEOUT);
+        removePending(ctl, 0);
+    }
+}
@@ -0,0 +1,88 @@
+/*****************************************************************************/
+/**
+*  Brief: 	Contains definition for the UDP control protocol of the server.
+*
+*           A message is a sequence of 16-bit big-endian fields:
+*           WRITE: [operation][object][property][value]
+*           READ:  [operation][object][property], answered with the value appended
+*
+*  Created: 16.10.2026
+*  Author: 	Yurii Shenbor
+*
+******************************************************************************/
+
+#ifndef __CONTROL_H__
+#define __CONTROL_H__
+
+/***************************** Include Files ********************************/
+
+#include "client_lib.h"
+#include <poll.h>
+
+/************************** Constant Definitions *****************************/
+
+#define CONTROL_MSG_MAX         8       // Bytes of the longest message
+#define CONTROL_BATCH_MAX       16      // Messages sent with a single syscall
+#define CONTROL_PENDING_MAX     16      // Writes waiting for a read-back at once
+#define CONTROL_ACK_TIMEOUT_MS  100     // A write not confirmed within this time is reported
+
+enum operation_e {
+    READ = 1,
+    WRITE = 2
+};
+
+enum object_e {
+    CHANNEL_1 = 1,
+    CHANNEL_2 = 2,
+    CHANNEL_3 = 3
+};
+
+enum property_e {
+    ENABLED = 14,
+    MIN_DURATION = 42,  // For channel 3 only
+    MAX_DURATION = 43,  // For channel 3 only
+    AMPLITUDE = 170,
+    FREQUENCY = 255,
+    GLITCH_CHANCE = 300
+};
+
+/**************************** Type Definitions *******************************/
+
+// Message in wire format
+struct control_msg_t {
+    uint8_t size;
+    uint8_t data[CONTROL_MSG_MAX];
+};
+
+// Write waiting for its read-back
+struct control_pending_t {
+    uint16_t object;
+    uint16_t property;
+    uint16_t value;
+    uint64_t sent_ns;
+};
+
+struct control_t {
+    int sockfd;
+    struct sockaddr_in addr;
+    int ack;                            // read every written property back
+    unsigned pending_count;
+    struct control_pending_t pending[CONTROL_PENDING_MAX];
+    uint64_t acks;                      // writes confirmed by a read-back
+    uint64_t mismatches;                // read-backs with another value
+    uint64_t timeouts;                  // writes without a read-back
+};
+
+/************************** Function Prototypes ******************************/
+
+int initControl(struct control_t *ctl, struct in_addr *sin_addr, int port, int ack);
+void closeControl(struct control_t *ctl);
+void encodeMessage(enum operation_e op, enum object_e obj, enum property_e prop, uint16_t val, struct control_msg_t *msg);
+int sendMessages(struct control_t *ctl, const struct control_msg_t *msgs, unsigned count);
+void pollAcks(struct control_t *ctl);
+int findProperty(const char *name);
+const char* propertyName(uint16_t property);
+
+int startServer(struct in_addr *sin_addr, int port, struct sockaddr_in *server_addr);
+
+#endif /* __CONTROL_H__ */
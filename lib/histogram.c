@@ -0,0 +1,131 @@
+/*****************************************************************************/
+/**
+*  Brief: 	Contains implementation of the log-linear (HDR-style) histogram.
+*
+*  Created: 16.10.2026
+*  Author: 	Yurii Shenbor
+*
+******************************************************************************/
+
+/***************************** Include Files ********************************/
+
+#include "histogram.h"
+
+/**************************************************************************/
+/**
+*
+* @brief    Finds the bucket of a value
+*
+* @param	value - the value
+*
+* @return	bucket number
+*
+* @note		No branches except for the exact range, no loops.
+*
+**************************************************************************/
+uint32_t histogramBucket(uint64_t value) {
+    if (value < HISTOGRAM_SUB_COUNT) {
+        return value;
+    }
+
+    uint32_t shift = (63 - __builtin_clzll(value)) - (HISTOGRAM_SUB_BITS - 1);
+    uint32_t top = value >> shift;      // HISTOGRAM_SUB_COUNT / 2 ... HISTOGRAM_SUB_COUNT - 1
+
+    return HISTOGRAM_SUB_COUNT + (shift - 1) * (HISTOGRAM_SUB_COUNT / 2) + (top - HISTOGRAM_SUB_COUNT / 2);
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Gets the largest value counted in a bucket
+*
+* @param	bucket - bucket number
+*
+* @return	the value
+*
+* @note		Percentiles are reported by the upper bound, so they never understate.
+*
+**************************************************************************/
+uint64_t bucketValue(uint32_t bucket) {
+    if (bucket < HISTOGRAM_SUB_COUNT) {
+        return bucket;
+    }
+
+    uint32_t shift = (bucket - HISTOGRAM_SUB_COUNT) / (HISTOGRAM_SUB_COUNT / 2) + 1;
+    uint64_t top = (bucket - HISTOGRAM_SUB_COUNT) % (HISTOGRAM_SUB_COUNT / 2) + HISTOGRAM_SUB_COUNT / 2;
+
+    return ((top + 1) << shift) - 1;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Clears the histogram
+*
+* @param	[out] histogram - the histogram
+*
+* @return	None
+*
+* @note		None
+*
+**************************************************************************/
+void initHistogram(struct histogram_t *histogram) {
+    memset(histogram, 0, sizeof(*histogram));
+    histogram->min = UINT64_MAX;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Counts a value
+*
+* @param	histogram - the histogram
+* @param	value - the value
+*
+* @return	None
+*
+* @note		None
+*
+**************************************************************************/
+void recordValue(struct histogram_t *histogram, uint64_t value) {
+    histogram->buckets[histogramBucket(value)]++;
+    histogram->count++;
+    histogram->sum += value;
+    histogram->min = (value < histogram->min) ? value : histogram->min;
+    histogram->max = (value > histogram->max) ? value : histogram->max;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Gets the value below which the given share of the counted values lies
+*
+* @param	histogram - the histogram
+* @param	percentile - 0 ... 100
+*
+* @return	the value, 0 if nothing was counted
+*
+* @note		The exact maximum is returned for the top bucket.
+*
+**************************************************************************/
+uint64_t valueAtPercentile(const struct histogram_t *histogram, double percentile) {
+    uint64_t rank = (uint64_t)(percentile / 100.0 * histogram->count + 0.5);
+    uint64_t seen = 0;
+
+    if (histogram->count == 0) {
+        return 0;
+    }
+    if (rank == 0) {
+        rank = 1;
+    }
+
+    for (uint32_t bucket = 0; bucket < HISTOGRAM_BUCKETS; ++bucket) {
+        seen += histogram->buckets[bucket];
+        if (seen >= rank) {
+            uint64_t value = bucketValue(bucket);
+            return (value < histogram->max) ? value : histogram->max;
+        }
+    }
+
+    return histogram->max;
+}
@@ -0,0 +1,44 @@
+/*****************************************************************************/
+/**
+*  Brief: 	Contains definition for the log-linear (HDR-style) histogram. Values
+*           below 2^HISTOGRAM_SUB_BITS are counted exactly, larger values keep
+*           HISTOGRAM_SUB_BITS significant bits (below 1% error).
+*
+*  Created: 16.10.2026
+*  Author: 	Yurii Shenbor
+*
+******************************************************************************/
+
+#ifndef __HISTOGRAM_H__
+#define __HISTOGRAM_H__
+
+/***************************** Include Files ********************************/
+
+#include <stdint.h>
+#include <string.h>
+
+/************************** Constant Definitions *****************************/
+
+#define HISTOGRAM_SUB_BITS      7
+#define HISTOGRAM_SUB_COUNT     (1u << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_BUCKETS       (HISTOGRAM_SUB_COUNT + (64 - HISTOGRAM_SUB_BITS) * (HISTOGRAM_SUB_COUNT / 2))
+
+/**************************** Type Definitions *******************************/
+
+struct histogram_t {
+    uint64_t count;
+    uint64_t sum;
+    uint64_t min;
+    uint64_t max;
+    uint64_t buckets[HISTOGRAM_BUCKETS];
+};
+
+/************************** Function Prototypes ******************************/
+
+void initHistogram(struct histogram_t *histogram);
+void recordValue(struct histogram_t *histogram, uint64_t value);
+uint64_t valueAtPercentile(const struct histogram_t *histogram, double percentile);
+uint32_t histogramBucket(uint64_t value);
+uint64_t bucketValue(uint32_t bucket);
+
+#endif /* __HISTOGRAM_H__ */
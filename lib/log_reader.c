@@ -0,0 +1,316 @@
+/*****************************************************************************/
+/**
+*  Brief: 	Contains implementation of the streaming log reader.
+*
+*  Created: 16.10.2026
+*  Author: 	Yurii Shenbor
+*
+******************************************************************************/
+
+/***************************** Include Files ********************************/
+
+#define _GNU_SOURCE     // memmem
+
+#include "log_reader.h"
+
+/************************** Function Prototypes ******************************/
+
+static const char* nextLine(struct log_reader_t *reader, const char **end);
+static int parseLogLine(const char *line, const char *end, int64_t *timestamp, int32_t *values, uint32_t stride, uint32_t channels);
+static uint32_t lowerBound(const int64_t *timestamps, uint32_t rows, int64_t timestamp);
+
+/**************************************************************************/
+/**
+*
+* @brief    Gets the next line of a JSON log
+*
+* @param	reader - log reader
+* @param	[out] end - position of the line end
+*
+* @return	start of the line, NULL at the end of the file
+*
+* @note		The line stays valid until the next call. A line longer than the
+*           read chunk is split and its parts fail to parse.
+*
+**************************************************************************/
+static const char* nextLine(struct log_reader_t *reader, const char **end) {
+    while (1) {
+        char *start = reader->chunk + reader->chunk_pos;
+        char *newline = memchr(start, '\n', reader->chunk_used - reader->chunk_pos);
+
+        if (newline != NULL) {
+            reader->chunk_pos = newline - reader->chunk + 1;
+            *end = newline;
+            return start;
+        }
+
+        if (reader->eof) {
+            if (reader->chunk_pos == reader->chunk_used) {
+                return NULL;
+            }
+            reader->chunk_pos = reader->chunk_used;
+            *end = reader->chunk + reader->chunk_used;
+            return start;
+        }
+
+        // Keep the partial line and read more data after it
+        reader->chunk_used -= reader->chunk_pos;
+        memmove(reader->chunk, start, reader->chunk_used);
+        reader->chunk_pos = 0;
+        if (reader->chunk_used == LOG_READER_CHUNK) {
+            reader->chunk_used = 0;
+        }
+
+        ssize_t status = read(reader->fd, reader->chunk + reader->chunk_used, LOG_READER_CHUNK - reader->chunk_used);
+        if (status < 0 && errno == EINTR) {
+            continue;
+        }
+        if (status <= 0) {
+            reader->eof = 1;
+        } else {
+            reader->chunk_used += status;
+        }
+    }
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Parses a log line `{"timestamp": T, "key": "v", ...}` into a row
+*
+* @param	line - start of the line
+* @param	end - end of the line
+* @param	[out] timestamp - time of the line
+* @param	[out] values - first value of the row, may be NULL to only count the values
+* @param	stride - distance between value columns
+* @param	channels - number of value columns
+*
+* @return	number of values in the line, -1 if the line is not a log line
+*
+* @note		Values that are not numbers (i.e. "--") are stored as BIN_LOG_INVALID.
+*
+**************************************************************************/
+static int parseLogLine(const char *line, const char *end, int64_t *timestamp, int32_t *values, uint32_t stride, uint32_t channels) {
+    const char *ptr = memchr(line, ':', end - line);
+    int64_t time = 0;
+    int count = 0;
+
+    if (ptr == NULL) {
+        return -1;
+    }
+    while (++ptr < end && *ptr == ' ') {
+    }
+    if (ptr == end || *ptr < '0' || *ptr > '9') {
+        return -1;
+    }
+    while (ptr < end && *ptr >= '0' && *ptr <= '9') {
+        time = time * 10 + (*ptr++ - '0');
+    }
+    *timestamp = time;
+
+    while ((ptr = memchr(ptr, ':', end - ptr)) != NULL) {
+        while (++ptr < end && *ptr == ' ') {
+        }
+        if (ptr == end || *ptr != '"') {
+            break;
+        }
+
+        const char *value = ptr + 1;
+        if ((ptr = memchr(value, '"', end - value)) == NULL) {
+            break;
+        }
+
+        if (values != NULL && (uint32_t)count < channels) {
+            struct sample_t sample;
+            values[count * stride] = (parseSample(value, ptr - value, &sample) == 0) ? sample.value : BIN_LOG_INVALID;
+        }
+        count++;
+    }
+
+    return count;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Opens a JSON lines log or a binary log for reading
+*
+* @param	[out] reader - log reader
+* @param	path - path to the file, the format is taken from its contents
+* @param	from_ms - first timestamp to read
+* @param	to_ms - last timestamp to read
+*
+* @return	0 on success, otherwise -1
+*
+* @note		The number of channels of a JSON log is taken from its first line.
+*
+**************************************************************************/
+int openLogReader(struct log_reader_t *reader, const char *path, int64_t from_ms, int64_t to_ms) {
+    char magic[sizeof(BIN_LOG_MAGIC)] = {0};
+    const char *line, *end;
+    int64_t timestamp;
+
+    memset(reader, 0, sizeof(*reader));
+    reader->from_ms = from_ms;
+    reader->to_ms = to_ms;
+
+    if ((reader->fd = open(path, O_RDONLY)) < 0) {
+        return -1;
+    }
+
+    if (read(reader->fd, magic, sizeof(magic)) == sizeof(magic) && memcmp(magic, BIN_LOG_MAGIC, sizeof(magic)) == 0) {
+        close(reader->fd);
+        reader->binary = 1;
+        if (openBinLogReader(&reader->bin, path) < 0) {
+            return -1;
+        }
+        reader->channels = reader->bin.header->channels;
+        reader->flags = reader->bin.header->flags;
+        reader->block = findBinLogBlock(&reader->bin, from_ms);
+        return 0;
+    }
+
+    posix_fadvise(reader->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    if (lseek(reader->fd, 0, SEEK_SET) < 0 || (reader->chunk = malloc(LOG_READER_CHUNK)) == NULL) {
+        closeLogReader(reader);
+        return -1;
+    }
+
+    // Take the layout from the first log line, then start over
+    while ((line = nextLine(reader, &end)) != NULL) {
+        int count = parseLogLine(line, end, &timestamp, NULL, 0, 0);
+        if (count > 0) {
+            reader->channels = count;
+            reader->flags = (memmem(line, end - line, "\"data\":", 7) != NULL) ? BIN_LOG_KEYS_DATA : 0;
+            break;
+        }
+    }
+
+    if (reader->channels == 0 || lseek(reader->fd, 0, SEEK_SET) < 0) {
+        closeLogReader(reader);
+        return -1;
+    }
+    reader->chunk_used = reader->chunk_pos = 0;
+    reader->eof = 0;
+
+    reader->timestamps = malloc(LOG_READER_ROWS * sizeof(*reader->timestamps));
+    reader->values = malloc((size_t)LOG_READER_ROWS * reader->channels * sizeof(*reader->values));
+    if (reader->timestamps == NULL || reader->values == NULL) {
+        closeLogReader(reader);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Finds the first row not older than the given timestamp
+*
+* @param	timestamps - timestamp column
+* @param	rows - number of rows
+* @param	timestamp - time in milliseconds
+*
+* @return	row number, rows if all rows are older
+*
+**************************************************************************/
+static uint32_t lowerBound(const int64_t *timestamps, uint32_t rows, int64_t timestamp) {
+    uint32_t low = 0, high = rows;
+
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        if (timestamps[mid] < timestamp) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Reads the next block of rows within the time range
+*
+* @param	reader - log reader
+* @param	[out] block - rows and column pointers of the block
+*
+* @return	number of rows in the block, 0 at the end of the log
+*
+* @note		Blocks of an uncompressed binary log point into the mapped file, other
+*           blocks stay valid until the next call.
+*
+**************************************************************************/
+uint32_t readLogBlock(struct log_reader_t *reader, struct bin_log_block_t *block) {
+    if (reader->binary) {
+        while (getBinLogBlock(&reader->bin, reader->block, block) == 0) {
+            reader->block++;
+
+            uint32_t first = lowerBound(block->timestamps, block->rows, reader->from_ms);
+            uint32_t last = (reader->to_ms == INT64_MAX) ? block->rows : lowerBound(block->timestamps, block->rows, reader->to_ms + 1);
+            if (last < block->rows) {
+                reader->block = reader->bin.block_count;
+            }
+            if (first < last) {
+                block->rows = last - first;
+                block->timestamps += first;
+                block->values += first;
+                return block->rows;
+            }
+        }
+        return 0;
+    }
+
+    const char *line, *end;
+    uint32_t rows = 0;
+
+    while (rows < LOG_READER_ROWS && (line = nextLine(reader, &end)) != NULL) {
+        int count = parseLogLine(line, end, &reader->timestamps[rows], &reader->values[rows], LOG_READER_ROWS, reader->channels);
+        if (count < 0 || reader->timestamps[rows] < reader->from_ms) {
+            continue;
+        }
+        if (reader->timestamps[rows] > reader->to_ms) {
+            // Skip the rest of the file
+            reader->eof = 1;
+            reader->chunk_pos = reader->chunk_used;
+            break;
+        }
+        for (uint32_t ch = count; ch < reader->channels; ++ch) {
+            reader->values[ch * LOG_READER_ROWS + rows] = BIN_LOG_INVALID;
+        }
+        rows++;
+    }
+
+    block->rows = rows;
+    block->stride = LOG_READER_ROWS;
+    block->timestamps = reader->timestamps;
+    block->values = reader->values;
+    return rows;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Closes the log and releases the reader memory
+*
+* @param	reader - log reader
+*
+* @return	None
+*
+* @note		None
+*
+**************************************************************************/
+void closeLogReader(struct log_reader_t *reader) {
+    if (reader->binary) {
+        closeBinLogReader(&reader->bin);
+    } else if (reader->fd >= 0) {
+        close(reader->fd);
+    }
+    free(reader->chunk);
+    free(reader->timestamps);
+    free(reader->values);
+    memset(reader, 0, sizeof(*reader));
+}
@@ -0,0 +1,53 @@
+/*****************************************************************************/
+/**
+*  Brief: 	Contains definition for the streaming log reader. JSON lines logs and
+*           binary logs are both read as blocks of columns, with constant memory.
+*
+*  Created: 16.10.2026
+*  Author: 	Yurii Shenbor
+*
+******************************************************************************/
+
+#ifndef __LOG_READER_H__
+#define __LOG_READER_H__
+
+/***************************** Include Files ********************************/
+
+#include "client_lib.h"
+#include "bin_log.h"
+
+/************************** Constant Definitions *****************************/
+
+#define LOG_READER_ROWS         4096            // Rows per block read from a JSON log
+#define LOG_READER_CHUNK        (1 << 20)       // Size of a single read from a JSON log
+
+/**************************** Type Definitions *******************************/
+
+struct log_reader_t {
+    int binary;
+    uint32_t channels;
+    uint16_t flags;                     // BIN_LOG_* header flags
+    int64_t from_ms;                    // rows outside the range are skipped
+    int64_t to_ms;
+
+    // Binary log
+    struct bin_log_reader_t bin;
+    uint32_t block;                     // next block
+
+    // JSON log
+    int fd;
+    char *chunk;
+    size_t chunk_used;
+    size_t chunk_pos;
+    int eof;
+    int64_t *timestamps;
+    int32_t *values;                    // column of channel c starts at c * LOG_READER_ROWS
+};
+
+/************************** Function Prototypes ******************************/
+
+int openLogReader(struct log_reader_t *reader, const char *path, int64_t from_ms, int64_t to_ms);
+uint32_t readLogBlock(struct log_reader_t *reader, struct bin_log_block_t *block);
+void closeLogReader(struct log_reader_t *reader);
+
+#endif /* __LOG_READER_H__ */
@@ -0,0 +1,471 @@
+/*****************************************************************************/
+/**
+*  Brief: 	Contains implementation of the JSON lines writer used by client apps.
+*
+*  Created: 16.10.2026
+*  Author: 	Yurii Shenbor
+*
+******************************************************************************/
+
+/***************************** Include Files ********************************/
+
+#include "output.h"
+
+/************************** Constant Definitions *****************************/
+
+static const char digit_pairs[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static const struct {
+    unsigned flag;
+    const char *name;
+} aggregate_names[] = {
+    { AGGREGATE_MIN,   "min" },
+    { AGGREGATE_MAX,   "max" },
+    { AGGREGATE_MEAN,  "mean" },
+    { AGGREGATE_COUNT, "count" },
+    { AGGREGATE_LAST,  "last" },
+};
+
+/************************** Function Prototypes ******************************/
+
+static char* putUnsigned(char *ptr, uint64_t value);
+static char* putSample(char *ptr, struct sample_t sample);
+static char* putAggregate(char *ptr, const struct sample_aggregate_t *aggregate, unsigned aggregates);
+static void commitLine(struct output_t *out, char *end, unsigned long int timestamp);
+
+/**************************************************************************/
+/**
+*
+* @brief    Writes an unsigned integer in decimal form
+*
+* @param	ptr - position in the output buffer
+* @param	value - the value to write
+*
+* @return	position after the last written character
+*
+* @note		Digits are produced two at a time from a lookup table.
+*
+**************************************************************************/
+static char* putUnsigned(char *ptr, uint64_t value) {
+    char digits[20];
+    char *end = digits + sizeof(digits);
+    char *pos = end;
+
+    while (value >= 100) {
+        unsigned pair = (value % 100) * 2;
+        value /= 100;
+        *--pos = digit_pairs[pair + 1];
+        *--pos = digit_pairs[pair];
+    }
+    if (value >= 10) {
+        *--pos = digit_pairs[value * 2 + 1];
+        *--pos = digit_pairs[value * 2];
+    } else {
+        *--pos = '0' + value;
+    }
+
+    memcpy(ptr, pos, end - pos);
+    return ptr + (end - pos);
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Writes a sample in the server text format (i.e. "-2.9")
+*
+* @param	ptr - position in the output buffer
+* @param	sample - the value to write
+*
+* @return	position after the last written character
+*
+* @note		Invalid samples are written as "--".
+*
+**************************************************************************/
+static char* putSample(char *ptr, struct sample_t sample) {
+    if (!sample.valid) {
+        ptr[0] = ptr[1] = '-';
+        return ptr + 2;
+    }
+
+    uint32_t value = (uint32_t)sample.value;
+    if (sample.value < 0) {
+        *ptr++ = '-';
+        value = -value;
+    }
+
+    ptr = putUnsigned(ptr, value / 10);
+    ptr[0] = '.';
+    ptr[1] = '0' + value % 10;
+    return ptr + 2;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Writes the selected aggregates of a channel (i.e. {"min": "-2.9", "count": 5})
+*
+* @param	ptr - position in the output buffer
+* @param	aggregate - aggregates of the channel
+* @param	aggregates - aggregates to write (enum aggregate_e)
+*
+* @return	position after the last written character
+*
+* @note		Values are in the server text format, the mean is rounded to tenths.
+*           A channel without samples is written as "--".
+*
+**************************************************************************/
+static char* putAggregate(char *ptr, const struct sample_aggregate_t *aggregate, unsigned aggregates) {
+    struct sample_t sample = { .valid = 1 };
+    char separator = '{';
+
+    if (aggregate->count == 0) {
+        memcpy(ptr, "\"--\"", 4);
+        return ptr + 4;
+    }
+
+#define PUT_KEY(text) \
+    *ptr++ = separator; \
+    if (separator == ',') { \
+        *ptr++ = ' '; \
+    } \
+    separator = ','; \
+    memcpy(ptr, text, sizeof(text) - 1); \
+    ptr += sizeof(text) - 1;
+
+#define PUT_SAMPLE(text, field) \
+    PUT_KEY(text); \
+    sample.value = (field); \
+    ptr = putSample(ptr, sample); \
+    *ptr++ = '"';
+
+    if (aggregates & AGGREGATE_MIN) {
+        PUT_SAMPLE("\"min\": \"", aggregate->min);
+    }
+    if (aggregates & AGGREGATE_MAX) {
+        PUT_SAMPLE("\"max\": \"", aggregate->max);
+    }
+    if (aggregates & AGGREGATE_MEAN) {
+        int64_t half = aggregate->count / 2;
+        PUT_SAMPLE("\"mean\": \"", ((aggregate->sum < 0) ? aggregate->sum - half : aggregate->sum + half) / (int64_t)aggregate->count);
+    }
+    if (aggregates & AGGREGATE_COUNT) {
+        PUT_KEY("\"count\": ");
+        ptr = putUnsigned(ptr, aggregate->count);
+    }
+    if (aggregates & AGGREGATE_LAST) {
+        PUT_SAMPLE("\"last\": \"", aggregate->last);
+    }
+#undef PUT_SAMPLE
+#undef PUT_KEY
+
+    *ptr++ = '}';
+    return ptr;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Allocates the output buffer and precomputes key fragments
+*
+* @param	[out] out - output writer
+* @param	fd - file descriptor to write to
+* @param	channels - number of channels in every tick line
+* @param	flush_lines - flush after this many lines, 0 or 1 to flush every line
+* @param	flush_ms - flush if the oldest buffered line is older than this, 0 to ignore
+*
+* @return	0 on success, otherwise -1
+*
+* @note		Nothing is allocated after initialization.
+*
+**************************************************************************/
+int initOutput(struct output_t *out, int fd, size_t channels, unsigned flush_lines, unsigned long flush_ms) {
+    memset(out, 0, sizeof(*out));
+    out->fd = fd;
+    out->channels = channels;
+    out->flush_lines = (flush_lines > 0) ? flush_lines : 1;
+    out->flush_ms = flush_ms;
+
+    out->keys = calloc(channels ? channels : 1, OUTPUT_KEY_SIZE);
+    out->key_size = calloc(channels ? channels : 1, sizeof(*out->key_size));
+    if (out->keys == NULL || out->key_size == NULL) {
+        closeOutput(out);
+        return -1;
+    }
+
+    out->line_max = OUTPUT_LINE_EXTRA;
+    for (size_t i = 0; i < channels; ++i) {
+        out->key_size[i] = snprintf(out->keys[i], OUTPUT_KEY_SIZE, ", \"out%zu\": \"", i + 1);
+        out->line_max += out->key_size[i] + SAMPLE_TEXT_SIZE + 1;
+    }
+
+    out->capacity = out->line_max * out->flush_lines;
+    if ((out->buffer = malloc(out->capacity)) == NULL) {
+        closeOutput(out);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Accounts a finished line and flushes the buffer if the policy says so
+*
+* @param	out - output writer
+* @param	end - position after the line
+* @param	timestamp - timestamp of the line in milliseconds
+*
+* @return	None
+*
+* @note		None
+*
+**************************************************************************/
+static void commitLine(struct output_t *out, char *end, unsigned long int timestamp) {
+    out->used = end - out->buffer;
+    if (out->lines++ == 0) {
+        out->first_ms = timestamp;
+    }
+
+    if (out->lines >= out->flush_lines || out->capacity - out->used < out->line_max ||
+        (out->flush_ms > 0 && timestamp - out->first_ms >= out->flush_ms)) {
+        flushOutput(out);
+    }
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Adds a tick line `{"timestamp": T, "out1": "v1", ...}` to the output
+*
+* @param	out - output writer
+* @param	timestamp - time of the tick in milliseconds
+* @param	values - values of all channels
+*
+* @return	None
+*
+* @note		None
+*
+**************************************************************************/
+void writeTick(struct output_t *out, unsigned long int timestamp, const struct sample_t *values) {
+    char *ptr = out->buffer + out->used;
+
+    memcpy(ptr, "{\"timestamp\": ", 14);
+    ptr = putUnsigned(ptr + 14, timestamp);
+
+    for (size_t i = 0; i < out->channels; ++i) {
+        memcpy(ptr, out->keys[i], OUTPUT_KEY_SIZE);
+        ptr = putSample(ptr + out->key_size[i], values[i]);
+        *ptr++ = '"';
+    }
+
+    ptr[0] = '}';
+    ptr[1] = '\n';
+    commitLine(out, ptr + 2, timestamp);
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Parses a comma separated list of aggregates (i.e. "min,max,mean")
+*
+* @param	list - names of the aggregates, "all" for every one
+*
+* @return	bit mask of enum aggregate_e, 0 if the list is empty or has an unknown name
+*
+* @note		None
+*
+**************************************************************************/
+unsigned parseAggregates(const char *list) {
+    unsigned aggregates = 0;
+
+    while (*list != '\0') {
+        size_t size = strcspn(list, ",");
+        unsigned flag = 0;
+
+        if (size == 3 && strncmp(list, "all", 3) == 0) {
+            flag = AGGREGATE_ALL;
+        }
+        for (size_t i = 0; i < sizeof(aggregate_names) / sizeof(aggregate_names[0]); ++i) {
+            if (strlen(aggregate_names[i].name) == size && strncmp(list, aggregate_names[i].name, size) == 0) {
+                flag = aggregate_names[i].flag;
+            }
+        }
+        if (flag == 0) {
+            return 0;
+        }
+
+        aggregates |= flag;
+        list += size;
+        if (*list == ',') {
+            ++list;
+        }
+    }
+
+    return aggregates;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Switches the output to aggregate lines and grows the buffer for them
+*
+* @param	out - output writer
+* @param	aggregates - aggregates to write per channel (enum aggregate_e)
+*
+* @return	0 on success, otherwise -1
+*
+* @note		Must be called before the first line is written.
+*
+**************************************************************************/
+int enableOutputAggregates(struct output_t *out, unsigned aggregates) {
+    size_t line_max = OUTPUT_LINE_EXTRA;
+    char *buffer;
+
+    for (size_t i = 0; i < out->channels; ++i) {
+        line_max += out->key_size[i] + 2 + OUTPUT_AGGREGATE_SIZE * __builtin_popcount(aggregates);
+    }
+
+    if (line_max > out->line_max) {
+        if ((buffer = realloc(out->buffer, line_max * out->flush_lines)) == NULL) {
+            return -1;
+        }
+        out->buffer = buffer;
+        out->line_max = line_max;
+        out->capacity = line_max * out->flush_lines;
+    }
+
+    out->aggregates = aggregates;
+    return 0;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Adds an aggregate line `{"timestamp": T, "out1": {"min": "v", ...}, ...}` to the output
+*
+* @param	out - output writer
+* @param	timestamp - time of the tick in milliseconds
+* @param	aggregates - aggregates of all channels over the output period
+*
+* @return	None
+*
+* @note		Only the aggregates enabled by enableOutputAggregates are written.
+*
+**************************************************************************/
+void writeAggregates(struct output_t *out, unsigned long int timestamp, const struct sample_aggregate_t *aggregates) {
+    char *ptr = out->buffer + out->used;
+
+    memcpy(ptr, "{\"timestamp\": ", 14);
+    ptr = putUnsigned(ptr + 14, timestamp);
+
+    for (size_t i = 0; i < out->channels; ++i) {
+        // The key fragment ends with the opening quote of a plain value, it is overwritten
+        memcpy(ptr, out->keys[i], OUTPUT_KEY_SIZE);
+        ptr = putAggregate(ptr + out->key_size[i] - 1, &aggregates[i], out->aggregates);
+    }
+
+    ptr[0] = '}';
+    ptr[1] = '\n';
+    commitLine(out, ptr + 2, timestamp);
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Adds a log line `{"timestamp": T, "data": "v"}` to the output
+*
+* @param	out - output writer
+* @param	timestamp - time of the sample in milliseconds
+* @param	sample - the value
+*
+* @return	None
+*
+* @note		None
+*
+**************************************************************************/
+void writeLogRecord(struct output_t *out, unsigned long int timestamp, struct sample_t sample) {
+    char *ptr = out->buffer + out->used;
+
+    memcpy(ptr, "{\"timestamp\": ", 14);
+    ptr = putUnsigned(ptr + 14, timestamp);
+    memcpy(ptr, ", \"data\": \"", 11);
+    ptr = putSample(ptr + 11, sample);
+    memcpy(ptr, "\"}\n", 3);
+    commitLine(out, ptr + 3, timestamp);
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Flushes the buffer if its oldest line is older than flush_ms
+*
+* @param	out - output writer
+* @param	now_ms - current time in milliseconds, same clock as the line timestamps
+*
+* @return	None
+*
+* @note		Called from the wait loop of the caller, so buffered lines are
+*           written even if no further line comes (i.e. the stream stalls).
+*
+**************************************************************************/
+void expireOutput(struct output_t *out, unsigned long int now_ms) {
+    if (out->lines > 0 && out->flush_ms > 0 && now_ms - out->first_ms >= out->flush_ms) {
+        flushOutput(out);
+    }
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Writes all buffered lines with a single syscall
+*
+* @param	out - output writer
+*
+* @return	None
+*
+* @note		None
+*
+**************************************************************************/
+void flushOutput(struct output_t *out) {
+    size_t written = 0;
+
+    while (written < out->used) {
+        ssize_t status = write(out->fd, out->buffer + written, out->used - written);
+        if (status < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            error_exit("Output write failed");
+        }
+        written += status;
+    }
+
+    out->used = 0;
+    out->lines = 0;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Flushes the output and releases its memory
+*
+* @param	out - output writer
+*
+* @return	None
+*
+* @note		The file descriptor is not closed.
+*
+**************************************************************************/
+void closeOutput(struct output_t *out) {
+    if (out->buffer != NULL) {
+        flushOutput(out);
+    }
+    free(out->buffer);
+    free(out->keys);
+    free(out->key_size);
+    memset(out, 0, sizeof(*out));
+}
@@ -0,0 +1,64 @@
+/*****************************************************************************/
+/**
+*  Brief: 	Contains definition for the JSON lines writer used by client apps.
+*
+*  Created: 16.10.2026
+*  Author: 	Yurii Shenbor
+*
+******************************************************************************/
+
+#ifndef __OUTPUT_H__
+#define __OUTPUT_H__
+
+/***************************** Include Files ********************************/
+
+#include "client_lib.h"
+
+/************************** Constant Definitions *****************************/
+
+#define OUTPUT_KEY_SIZE     24      // Longest precomputed key fragment, i.e. `, "out1000000": "`
+#define OUTPUT_LINE_EXTRA   64      // Timestamp, braces and newline of a line
+#define OUTPUT_AGGREGATE_SIZE   32  // Longest aggregate of a channel, i.e. `, "mean": "-214748364.8"`
+
+/**************************** Type Definitions *******************************/
+
+// Aggregates that may be written per channel, combined as a bit mask
+enum aggregate_e {
+    AGGREGATE_MIN   = 1 << 0,
+    AGGREGATE_MAX   = 1 << 1,
+    AGGREGATE_MEAN  = 1 << 2,
+    AGGREGATE_COUNT = 1 << 3,
+    AGGREGATE_LAST  = 1 << 4,
+    AGGREGATE_ALL   = (1 << 5) - 1,
+};
+
+// Lines are built in a preallocated buffer and written with one syscall per batch
+struct output_t {
+    int fd;
+    char *buffer;
+    size_t used;
+    size_t capacity;
+    size_t line_max;                // longest possible line
+    char (*keys)[OUTPUT_KEY_SIZE];  // precomputed `, "outN": "` fragment of every channel
+    uint8_t *key_size;
+    size_t channels;
+    unsigned flush_lines;           // flush after this many lines, 0 or 1 to flush every line
+    unsigned long flush_ms;         // flush if the oldest buffered line is older than this (checked on writes and by expireOutput), 0 to ignore
+    unsigned lines;                 // lines in the buffer
+    unsigned long first_ms;         // timestamp of the oldest buffered line
+    unsigned aggregates;            // aggregates written by writeAggregates (enum aggregate_e)
+};
+
+/************************** Function Prototypes ******************************/
+
+int initOutput(struct output_t *out, int fd, size_t channels, unsigned flush_lines, unsigned long flush_ms);
+void writeTick(struct output_t *out, unsigned long int timestamp, const struct sample_t *values);
+int enableOutputAggregates(struct output_t *out, unsigned aggregates);
+void writeAggregates(struct output_t *out, unsigned long int timestamp, const struct sample_aggregate_t *aggregates);
+unsigned parseAggregates(const char *list);
+void writeLogRecord(struct output_t *out, unsigned long int timestamp, struct sample_t sample);
+void expireOutput(struct output_t *out, unsigned long int now_ms);
+void flushOutput(struct output_t *out);
+void closeOutput(struct output_t *out);
+
+#endif /* __OUTPUT_H__ */
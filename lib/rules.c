@@ -0,0 +1,407 @@
+/*****************************************************************************/
+/**
+*  Brief: 	Contains implementation of the control rule engine.
+*
+*  Created: 16.10.2026
+*  Author: 	Yurii Shenbor
+*
+******************************************************************************/
+
+/***************************** Include Files ********************************/
+
+#include "rules.h"
+#include "stats.h"
+#include <math.h>
+
+/************************** Function Prototypes ******************************/
+
+static int parseWrite(char *token, struct control_msg_t *msg);
+static int conditionHolds(uint32_t condition, int32_t value, int32_t threshold);
+
+/**************************************************************************/
+/**
+*
+* @brief    Initializes an empty rule set
+*
+* @param	[out] rules - rule set
+* @param	channel_count - number of channels in the channel table
+* @param	controls - controls the writes are sent with
+* @param	control_of - index in controls of every channel, NULL if there is a single control
+*
+* @return	None
+*
+* @note		None
+*
+**************************************************************************/
+void initRules(struct rules_t *rules, size_t channel_count, struct control_t *controls, const uint32_t *control_of) {
+    memset(rules, 0, sizeof(*rules));
+    rules->channel_count = channel_count;
+    rules->controls = controls;
+    rules->control_of = control_of;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Releases the memory of a rule set
+*
+* @param	rules - rule set
+*
+* @return	None
+*
+* @note		The controls are not closed.
+*
+**************************************************************************/
+void freeRules(struct rules_t *rules) {
+    free(rules->rules);
+    free(rules->first);
+    free(rules->watched);
+    free(rules->msgs);
+    free(rules->armed);
+    free(rules->fired_ns);
+    initRules(rules, 0, NULL, NULL);
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Parses a property write `<object>.<property>=<value>`
+*
+* @param	token - the write, the property is a name or a number
+* @param	[out] msg - the encoded message
+*
+* @return	0 on success, otherwise -1
+*
+* @note		None
+*
+**************************************************************************/
+static int parseWrite(char *token, struct control_msg_t *msg) {
+    char *dot = strchr(token, '.');
+    char *equal = strchr(token, '=');
+    char *end;
+
+    if (dot == NULL || equal == NULL || equal < dot) {
+        return -1;
+    }
+    *dot = '\0';
+    *equal = '\0';
+
+    unsigned long object = strtoul(token, &end, 10);
+    if (*end != '\0' || object == 0 || object > UINT16_MAX) {
+        return -1;
+    }
+
+    long property = strtol(dot + 1, &end, 10);
+    if (*end != '\0') {
+        property = findProperty(dot + 1);
+    }
+    if (property <= 0 || property > UINT16_MAX) {
+        return -1;
+    }
+
+    unsigned long value = strtoul(equal + 1, &end, 10);
+    if (*end != '\0' || equal[1] == '\0' || value > UINT16_MAX) {
+        return -1;
+    }
+
+    encodeMessage(WRITE, object, property, value, msg);
+    return 0;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Adds a rule to the set
+*
+* @param	rules - rule set
+* @param	line - the rule in the config file format, '#' starts a comment
+*
+* @return	1 if a rule was added, 0 for an empty line, -1 if the rule is invalid
+*
+* @note		The set must be compiled again before it is evaluated.
+*
+**************************************************************************/
+int addRule(struct rules_t *rules, const char *line) {
+    char text[512];
+    char *tokens[5 + CONTROL_BATCH_MAX + 1];
+    char *save, *end;
+    int token_count = 0;
+    struct rule_t rule = {0};
+
+    snprintf(text, sizeof(text), "%s", line);
+    if ((end = strchr(text, '#')) != NULL) {
+        *end = '\0';
+    }
+    for (char *token = strtok_r(text, " \t\r\n", &save); token != NULL; token = strtok_r(NULL, " \t\r\n", &save)) {
+        if (token_count == sizeof(tokens) / sizeof(tokens[0])) {
+            goto invalid;
+        }
+        tokens[token_count++] = token;
+    }
+    if (token_count == 0) {
+        return 0;
+    }
+    if (token_count < 6 || token_count > 5 + CONTROL_BATCH_MAX) {
+        goto invalid;
+    }
+
+    unsigned long channel = strtoul(tokens[0], &end, 10);
+    if (*end != '\0' || channel == 0 || channel > rules->channel_count) {
+        goto invalid;
+    }
+    rule.channel = channel - 1;
+
+    if (strcmp(tokens[1], ">") == 0) {
+        rule.condition = RULE_ABOVE;
+    } else if (strcmp(tokens[1], ">=") == 0) {
+        rule.condition = RULE_AT_LEAST;
+    } else if (strcmp(tokens[1], "<") == 0) {
+        rule.condition = RULE_BELOW;
+    } else if (strcmp(tokens[1], "<=") == 0) {
+        rule.condition = RULE_AT_MOST;
+    } else {
+        goto invalid;
+    }
+
+    double threshold = strtod(tokens[2], &end);
+    if (*end != '\0') {
+        goto invalid;
+    }
+    double hysteresis = strtod(tokens[3], &end);
+    if (*end != '\0' || hysteresis < 0) {
+        goto invalid;
+    }
+    rule.threshold = lround(threshold * 10);
+    rule.release = (rule.condition == RULE_ABOVE || rule.condition == RULE_AT_LEAST) ?
+                   rule.threshold - lround(hysteresis * 10) : rule.threshold + lround(hysteresis * 10);
+
+    unsigned long interval_ms = strtoul(tokens[4], &end, 10);
+    if (*end != '\0') {
+        goto invalid;
+    }
+    rule.interval_ns = interval_ms * 1000000ull;
+
+    if (rules->msg_count + token_count - 5 > rules->msg_capacity) {
+        size_t capacity = rules->msg_capacity ? rules->msg_capacity * 2 : RULES_MIN_CAPACITY;
+        while (capacity < rules->msg_count + token_count - 5) {
+            capacity *= 2;
+        }
+        void *ptr = realloc(rules->msgs, capacity * sizeof(*rules->msgs));
+        if (ptr == NULL) {
+            error_exit("Unable to grow rules");
+        }
+        rules->msgs = ptr;
+        rules->msg_capacity = capacity;
+    }
+
+    rule.first_msg = rules->msg_count;
+    for (int i = 5; i < token_count; ++i) {
+        if (parseWrite(tokens[i], &rules->msgs[rule.first_msg + rule.msg_count]) < 0) {
+            goto invalid;
+        }
+        rule.msg_count++;
+    }
+
+    if (rules->count == rules->capacity) {
+        size_t capacity = rules->capacity ? rules->capacity * 2 : RULES_MIN_CAPACITY;
+        void *ptr = realloc(rules->rules, capacity * sizeof(*rules->rules));
+        if (ptr == NULL) {
+            error_exit("Unable to grow rules");
+        }
+        rules->rules = ptr;
+        rules->capacity = capacity;
+    }
+
+    rules->msg_count += rule.msg_count;
+    rules->rules[rules->count++] = rule;
+    return 1;
+
+invalid:
+    fprintf(stderr, "Invalid rule: %s", line);
+    if (line[0] == '\0' || line[strlen(line) - 1] != '\n') {
+        fprintf(stderr, "\n");
+    }
+    return -1;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Adds rules listed in a config file to the set
+*
+* @param	rules - rule set
+* @param	path - path to the file, one rule per line
+*
+* @return	number of rules added, -1 if the file can't be read or has an invalid rule
+*
+* @note		None
+*
+**************************************************************************/
+int loadRules(struct rules_t *rules, const char *path) {
+    FILE *fp = fopen(path, "r");
+    char line[512];
+    int count = 0;
+
+    if (!fp) {
+        perror("Unable to open rules");
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), fp)) {
+        int status = addRule(rules, line);
+        if (status < 0) {
+            fclose(fp);
+            return -1;
+        }
+        count += status;
+    }
+
+    fclose(fp);
+    return count;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Sorts the rules by channel and allocates their state
+*
+* @param	rules - rule set
+*
+* @return	0 on success, otherwise -1
+*
+* @note		All rules start armed. The order of rules of a channel is kept. Every
+*           rule is bound to the control of the server of its channel.
+*
+**************************************************************************/
+int compileRules(struct rules_t *rules) {
+    size_t count = rules->count ? rules->count : 1;
+    struct rule_t *sorted = malloc(count * sizeof(*sorted));
+
+    free(rules->first);
+    free(rules->watched);
+    free(rules->armed);
+    free(rules->fired_ns);
+    rules->first = calloc(rules->channel_count + 1, sizeof(*rules->first));
+    rules->watched = calloc(rules->channel_count ? rules->channel_count : 1, sizeof(*rules->watched));
+    rules->armed = malloc(count * sizeof(*rules->armed));
+    rules->fired_ns = calloc(count, sizeof(*rules->fired_ns));
+    if (sorted == NULL || rules->first == NULL || rules->watched == NULL || rules->armed == NULL || rules->fired_ns == NULL) {
+        free(sorted);
+        return -1;
+    }
+
+    // Counting sort, first[c] ends up at the first rule of channel c
+    for (size_t i = 0; i < rules->count; ++i) {
+        rules->rules[i].control = rules->control_of ? rules->control_of[rules->rules[i].channel] : 0;
+        rules->first[rules->rules[i].channel + 1]++;
+    }
+    rules->watched_count = 0;
+    for (size_t c = 0; c < rules->channel_count; ++c) {
+        if (rules->first[c + 1] > 0) {
+            rules->watched[rules->watched_count++] = c;
+        }
+        rules->first[c + 1] += rules->first[c];
+    }
+    for (size_t i = 0; i < rules->count; ++i) {
+        sorted[rules->first[rules->rules[i].channel]++] = rules->rules[i];
+    }
+    for (size_t c = rules->channel_count; c > 0; --c) {
+        rules->first[c] = rules->first[c - 1];
+    }
+    rules->first[0] = 0;
+
+    free(rules->rules);
+    rules->rules = sorted;
+    rules->capacity = count;
+    memset(rules->armed, 1, count * sizeof(*rules->armed));
+    return 0;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Compares a value with a threshold
+*
+* @param	condition - comparison
+* @param	value - the value
+* @param	threshold - the threshold
+*
+* @return	nonzero if the condition holds
+*
+* @note		None
+*
+**************************************************************************/
+static int conditionHolds(uint32_t condition, int32_t value, int32_t threshold) {
+    switch (condition) {
+    case RULE_ABOVE:
+        return value > threshold;
+    case RULE_AT_LEAST:
+        return value >= threshold;
+    case RULE_BELOW:
+        return value < threshold;
+    default:
+        return value <= threshold;
+    }
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Evaluates the rules of a channel against a new sample
+*
+* @param	rules - compiled rule set
+* @param	channel - index of the channel
+* @param	sample - the value
+* @param	now_ns - monotonic time the sample arrived
+*
+* @return	None
+*
+* @note		A rule whose writes could not be sent stays armed and is tried again
+*           with the next sample. Nothing is allocated. The time from the arrival
+*           to the sent writes is published in the metrics.
+*
+**************************************************************************/
+void evaluateRules(struct rules_t *rules, uint32_t channel, struct sample_t sample, uint64_t now_ns) {
+    if (!sample.valid || channel >= rules->channel_count) {
+        return;
+    }
+
+    for (uint32_t i = rules->first[channel]; i < rules->first[channel + 1]; ++i) {
+        const struct rule_t *rule = &rules->rules[i];
+
+        if (!rules->armed[i]) {
+            rules->armed[i] = !conditionHolds(rule->condition, sample.value, rule->release);
+            continue;
+        }
+        if (!conditionHolds(rule->condition, sample.value, rule->threshold) ||
+            now_ns - rules->fired_ns[i] < rule->interval_ns) {
+            continue;
+        }
+        if (sendMessages(&rules->controls[rule->control], &rules->msgs[rule->first_msg], rule->msg_count) == (int)rule->msg_count) {
+            rules->armed[i] = 0;
+            rules->fired_ns[i] = now_ns;
+            rules->fired++;
+            recordReaction(now_ns);
+        }
+    }
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Evaluates the rules against the values of a tick
+*
+* @param	rules - compiled rule set
+* @param	values - values of all channels
+* @param	now_ns - monotonic time of the tick
+*
+* @return	None
+*
+* @note		Only channels that have rules are visited.
+*
+**************************************************************************/
+void applyRules(struct rules_t *rules, const struct sample_t *values, uint64_t now_ns) {
+    for (size_t i = 0; i < rules->watched_count; ++i) {
+        evaluateRules(rules, rules->watched[i], values[rules->watched[i]], now_ns);
+    }
+}
@@ -0,0 +1,82 @@
+/*****************************************************************************/
+/**
+*  Brief: 	Contains definition for the control rule engine. Rules are loaded
+*           from a config file, one rule per line:
+*
+*           <channel> <condition> <threshold> <hysteresis> <interval_ms> <object>.<property>=<value> ...
+*
+*           i.e. "3 >= 3.0 0.2 100 1.frequency=1000 1.amplitude=8000" writes the
+*           frequency and amplitude of server output 1 when channel 3 reaches 3.0.
+*           A rule fires once when its condition becomes true and is armed again
+*           when the value leaves the hysteresis band. It does not fire more often
+*           than once per interval.
+*
+*           Rules are compiled into a flat table sorted by channel, a sample only
+*           touches the rules of its own channel. The writes of a rule go to the
+*           server of its channel.
+*
+*  Created: 16.10.2026
+*  Author: 	Yurii Shenbor
+*
+******************************************************************************/
+
+#ifndef __RULES_H__
+#define __RULES_H__
+
+/***************************** Include Files ********************************/
+
+#include "control.h"
+
+/************************** Constant Definitions *****************************/
+
+#define RULES_MIN_CAPACITY  16
+
+enum rule_condition_e {
+    RULE_ABOVE,         // >
+    RULE_AT_LEAST,      // >=
+    RULE_BELOW,         // <
+    RULE_AT_MOST        // <=
+};
+
+/**************************** Type Definitions *******************************/
+
+struct rule_t {
+    uint32_t channel;           // index in the channel table
+    uint32_t condition;         // enum rule_condition_e
+    int32_t threshold;          // in tenths of a volt
+    int32_t release;            // threshold the value must cross back to arm the rule again
+    uint64_t interval_ns;       // shortest time between two firings
+    uint32_t first_msg;         // writes of the rule, pre-encoded
+    uint32_t msg_count;
+    uint32_t control;           // index of the control of the server of the channel
+};
+
+struct rules_t {
+    size_t channel_count;
+    size_t count;
+    size_t capacity;
+    struct rule_t *rules;       // sorted by channel after compileRules
+    uint32_t *first;            // rules of channel c are first[c] ... first[c + 1] - 1
+    uint32_t *watched;          // channels that have rules
+    size_t watched_count;
+    struct control_msg_t *msgs;
+    size_t msg_count;
+    size_t msg_capacity;
+    uint8_t *armed;             // state of every rule
+    uint64_t *fired_ns;
+    struct control_t *controls; // one control per server host
+    const uint32_t *control_of; // index of the control of every channel, NULL for the first one
+    uint64_t fired;             // number of firings
+};
+
+/************************** Function Prototypes ******************************/
+
+void initRules(struct rules_t *rules, size_t channel_count, struct control_t *controls, const uint32_t *control_of);
+void freeRules(struct rules_t *rules);
+int addRule(struct rules_t *rules, const char *line);
+int loadRules(struct rules_t *rules, const char *path);
+int compileRules(struct rules_t *rules);
+void evaluateRules(struct rules_t *rules, uint32_t channel, struct sample_t sample, uint64_t now_ns);
+void applyRules(struct rules_t *rules, const struct sample_t *values, uint64_t now_ns);
+
+#endif /* __RULES_H__ */
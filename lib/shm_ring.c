@@ -0,0 +1,365 @@
+/*****************************************************************************/
+/**
+*  Brief: 	Contains implementation of the shared memory rings.
+*
+*  Created: 16.10.2026
+*  Author: 	Yurii Shenbor
+*
+******************************************************************************/
+
+/***************************** Include Files ********************************/
+
+#include "shm_ring.h"
+#include "stats.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/************************** Variable Definitions *****************************/
+
+struct ring_segment_t *client_rings = NULL;
+
+static char ring_name[64];
+
+/************************** Function Prototypes ******************************/
+
+static size_t ringSize(uint32_t record_words, uint32_t capacity);
+static _Atomic uint64_t* beginRecord(struct shm_ring_t *ring, uint64_t *sequence);
+static void commitRecord(struct shm_ring_t *ring, _Atomic uint64_t *slot, uint64_t sequence);
+
+/**************************************************************************/
+/**
+*
+* @brief    Gets the size of a ring with its slots
+*
+**************************************************************************/
+static size_t ringSize(uint32_t record_words, uint32_t capacity) {
+    size_t size = sizeof(struct shm_ring_t) + (size_t)capacity * (1 + record_words) * sizeof(uint64_t);
+    return (size + 63) & ~(size_t)63;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Creates the ring segment of the process in shared memory
+*
+* @param	channels - number of channels in a tick record
+* @param	sample_rings - number of raw sample rings, 0 to publish only ticks
+*
+* @return	0 on success, otherwise -1
+*
+* @note		The segment is published as /dev/shm/tcp_port_reader.<pid>.ring.
+*
+**************************************************************************/
+int initRings(uint32_t channels, uint32_t sample_rings) {
+    uint32_t ring_count = 1 + sample_rings;
+    uint32_t tick_words = 1 + (channels + 1) / 2;
+    size_t offset = (sizeof(struct ring_segment_t) + ring_count * sizeof(uint64_t) + 63) & ~(size_t)63;
+    size_t size = offset + ringSize(tick_words, RING_TICK_CAPACITY) + sample_rings * ringSize(2, RING_SAMPLE_CAPACITY);
+
+    snprintf(ring_name, sizeof(ring_name), STATS_SHM_PREFIX "%d" RING_SHM_SUFFIX, (int)getpid());
+    int fd = shm_open(ring_name, O_CREAT | O_RDWR | O_TRUNC, 0644);
+    if (fd < 0) {
+        return -1;
+    }
+    if (ftruncate(fd, size) < 0) {
+        close(fd);
+        shm_unlink(ring_name);
+        return -1;
+    }
+
+    struct ring_segment_t *segment = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (segment == MAP_FAILED) {
+        shm_unlink(ring_name);
+        return -1;
+    }
+
+    // The segment is zeroed by ftruncate, only the headers are filled
+    segment->version = RING_VERSION;
+    segment->ring_count = ring_count;
+    segment->channels = channels;
+    segment->size = size;
+
+    for (uint32_t i = 0; i < ring_count; ++i) {
+        struct shm_ring_t *ring = (struct shm_ring_t *)((char *)segment + offset);
+
+        ring->kind = (i == 0) ? RING_TICKS : RING_SAMPLES;
+        ring->record_words = (i == 0) ? tick_words : 2;
+        ring->capacity = (i == 0) ? RING_TICK_CAPACITY : RING_SAMPLE_CAPACITY;
+        ring->channels = channels;
+        segment->offsets[i] = offset;
+        offset += ringSize(ring->record_words, ring->capacity);
+    }
+
+    atomic_thread_fence(memory_order_release);
+    segment->magic = RING_MAGIC;
+
+    client_rings = segment;
+    return 0;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Removes the ring segment of the process
+*
+* @param	None
+*
+* @return	None
+*
+* @note		Consumers that have the segment mapped keep their mapping.
+*
+**************************************************************************/
+void closeRings(void) {
+    if (client_rings == NULL) {
+        return;
+    }
+
+    munmap(client_rings, client_rings->size);
+    shm_unlink(ring_name);
+    client_rings = NULL;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Gets a ring of a segment
+*
+* @param	segment - ring segment
+* @param	index - 0 for the tick ring, 1 ... for the sample rings
+*
+* @return	the ring, NULL if it doesn't exist
+*
+**************************************************************************/
+struct shm_ring_t* getRing(struct ring_segment_t *segment, uint32_t index) {
+    if (segment == NULL || index >= segment->ring_count) {
+        return NULL;
+    }
+    return (struct shm_ring_t *)((char *)segment + segment->offsets[index]);
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Marks the next slot of a ring as being written
+*
+* @param	ring - the ring, written only by the calling thread
+* @param	[out] sequence - sequence of the new record
+*
+* @return	the slot, the record words follow the sequence word
+*
+**************************************************************************/
+static _Atomic uint64_t* beginRecord(struct shm_ring_t *ring, uint64_t *sequence) {
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    _Atomic uint64_t *slot = &ring->slots[(head & (ring->capacity - 1)) * (1 + ring->record_words)];
+
+    atomic_store_explicit(&slot[0], 2 * head + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    *sequence = head;
+    return slot;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Marks a record complete and publishes it
+*
+* @param	ring - the ring
+* @param	slot - slot of the record
+* @param	sequence - sequence of the record
+*
+**************************************************************************/
+static void commitRecord(struct shm_ring_t *ring, _Atomic uint64_t *slot, uint64_t sequence) {
+    atomic_store_explicit(&slot[0], 2 * sequence + 2, memory_order_release);
+    atomic_store_explicit(&ring->head, sequence + 1, memory_order_release);
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Publishes the values of all channels of a tick
+*
+* @param	timestamp - time of the tick in milliseconds
+* @param	values - values of all channels
+*
+* @return	None
+*
+* @note		Does nothing if the rings are not published. Must be called from a single thread.
+*
+**************************************************************************/
+void publishTick(int64_t timestamp, const struct sample_t *values) {
+    struct shm_ring_t *ring = getRing(client_rings, 0);
+    uint64_t sequence;
+
+    if (ring == NULL) {
+        return;
+    }
+
+    _Atomic uint64_t *slot = beginRecord(ring, &sequence);
+    atomic_store_explicit(&slot[1], (uint64_t)timestamp, memory_order_relaxed);
+    for (uint32_t ch = 0; ch < ring->channels; ch += 2) {
+        uint32_t low = values[ch].valid ? (uint32_t)values[ch].value : (uint32_t)RING_INVALID;
+        uint32_t high = (uint32_t)RING_INVALID;
+        if (ch + 1 < ring->channels && values[ch + 1].valid) {
+            high = (uint32_t)values[ch + 1].value;
+        }
+        atomic_store_explicit(&slot[2 + ch / 2], low | ((uint64_t)high << 32), memory_order_relaxed);
+    }
+    commitRecord(ring, slot, sequence);
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Publishes a single sample as it was received
+*
+* @param	ring - sample ring of the calling thread
+* @param	channel - index of the channel
+* @param	sample - the value
+* @param	rx_ns - kernel arrival time (CLOCK_REALTIME), 0 to use the current time
+*
+* @return	None
+*
+* @note		None
+*
+**************************************************************************/
+void publishRawSample(struct shm_ring_t *ring, uint32_t channel, struct sample_t sample, uint64_t rx_ns) {
+    uint64_t sequence;
+
+    if (rx_ns == 0) {
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        rx_ns = (uint64_t)now.tv_sec * 1000000000ull + now.tv_nsec;
+    }
+
+    _Atomic uint64_t *slot = beginRecord(ring, &sequence);
+    atomic_store_explicit(&slot[1], rx_ns, memory_order_relaxed);
+    atomic_store_explicit(&slot[2], channel | ((uint64_t)(uint32_t)sample.value << 32), memory_order_relaxed);
+    commitRecord(ring, slot, sequence);
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Maps a ring of a running client for reading
+*
+* @param	[out] consumer - consumer state
+* @param	pid - process id of the client
+* @param	index - 0 for the tick ring, 1 ... for the sample rings
+* @param	from_oldest - start from the oldest record kept, otherwise from the next one
+*
+* @return	0 on success, otherwise -1
+*
+* @note		Every consumer has its own position, consumers don't affect each other
+*           or the producer.
+*
+**************************************************************************/
+int openRingConsumer(struct ring_consumer_t *consumer, int pid, uint32_t index, int from_oldest) {
+    char name[64];
+    struct stat info;
+
+    memset(consumer, 0, sizeof(*consumer));
+    snprintf(name, sizeof(name), STATS_SHM_PREFIX "%d" RING_SHM_SUFFIX, pid);
+
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (fstat(fd, &info) < 0 || (size_t)info.st_size < sizeof(struct ring_segment_t)) {
+        close(fd);
+        return -1;
+    }
+
+    struct ring_segment_t *segment = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (segment == MAP_FAILED) {
+        return -1;
+    }
+
+    if (segment->magic != RING_MAGIC || segment->version != RING_VERSION || segment->size != (uint64_t)info.st_size ||
+        (consumer->ring = getRing(segment, index)) == NULL) {
+        munmap(segment, info.st_size);
+        return -1;
+    }
+
+    consumer->segment = segment;
+    uint64_t head = atomic_load_explicit(&consumer->ring->head, memory_order_acquire);
+    if (!from_oldest) {
+        consumer->position = head;
+    } else if (head > consumer->ring->capacity) {
+        consumer->position = head - consumer->ring->capacity;
+    }
+
+    return 0;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Reads the next record of a ring
+*
+* @param	consumer - consumer state
+* @param	[out] record - record_words words of the record
+*
+* @return	1 if a record was read, 0 if there is no new record
+*
+* @note		Records overwritten before they could be read are skipped and added
+*           to consumer->lost.
+*
+**************************************************************************/
+int readRing(struct ring_consumer_t *consumer, uint64_t *record) {
+    struct shm_ring_t *ring = consumer->ring;
+    uint32_t words = ring->record_words;
+
+    while (1) {
+        uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        uint64_t position = consumer->position;
+
+        if (position >= head) {
+            return 0;
+        }
+        if (head - position > ring->capacity) {
+            // The producer has lapped this consumer
+            consumer->lost += head - ring->capacity - position;
+            position = consumer->position = head - ring->capacity;
+        }
+
+        _Atomic uint64_t *slot = &ring->slots[(position & (ring->capacity - 1)) * (1 + words)];
+        uint64_t sequence = atomic_load_explicit(&slot[0], memory_order_acquire);
+
+        if (sequence == 2 * position + 2) {
+            for (uint32_t w = 0; w < words; ++w) {
+                record[w] = atomic_load_explicit(&slot[1 + w], memory_order_relaxed);
+            }
+            atomic_thread_fence(memory_order_acquire);
+            if (atomic_load_explicit(&slot[0], memory_order_relaxed) == sequence) {
+                consumer->position++;
+                return 1;
+            }
+        }
+
+        // The slot is being reused for a newer record
+        consumer->lost++;
+        consumer->position++;
+    }
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Unmaps the ring segment
+*
+* @param	consumer - consumer state
+*
+* @return	None
+*
+* @note		None
+*
+**************************************************************************/
+void closeRingConsumer(struct ring_consumer_t *consumer) {
+    if (consumer->segment != NULL) {
+        munmap(consumer->segment, consumer->segment->size);
+    }
+    memset(consumer, 0, sizeof(*consumer));
+}
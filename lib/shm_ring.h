@@ -0,0 +1,94 @@
+/*****************************************************************************/
+/**
+*  Brief: 	Contains definition for the shared memory rings a client publishes its
+*           data in, so local processes can consume it without own connections.
+*
+*           Segment /dev/shm/tcp_port_reader.<pid>.ring:
+*           [ring_segment_t][offset of every ring][ring 0][ring 1]...
+*           Ring 0 holds tick records, rings 1 ... N hold raw samples, one ring per
+*           reader thread. Every ring has a single producer and any number of
+*           consumers. A ring is a header (the head sequence on its own cache line)
+*           followed by `capacity` slots of 1 + record_words 64-bit words:
+*           word 0 is the slot sequence (2n + 1 while record n is written, 2n + 2
+*           when it is complete), the rest is the record.
+*
+*           Tick record:   [timestamp ms][value 0 | value 1 << 32][...]
+*           Sample record: [timestamp ns, CLOCK_REALTIME][channel | value << 32], the
+*                          timestamp is the kernel arrival time if the client has it
+*           Values are int32 tenths of a volt, RING_INVALID for "--".
+*
+*           The producer never waits. A consumer that falls more than `capacity`
+*           records behind skips the overwritten records and counts them as lost.
+*
+*  Created: 16.10.2026
+*  Author: 	Yurii Shenbor
+*
+******************************************************************************/
+
+#ifndef __SHM_RING_H__
+#define __SHM_RING_H__
+
+/***************************** Include Files ********************************/
+
+#include "client_lib.h"
+
+/************************** Constant Definitions *****************************/
+
+#define RING_MAGIC              0x474e4952u     // "RING"
+#define RING_VERSION            1
+#define RING_SHM_SUFFIX         ".ring"
+#define RING_INVALID            INT32_MIN
+#define RING_TICK_CAPACITY      4096            // Slots of the tick ring, power of two
+#define RING_SAMPLE_CAPACITY    65536           // Slots of every sample ring, power of two
+
+enum ring_kind_e {
+    RING_TICKS = 1,
+    RING_SAMPLES = 2
+};
+
+/**************************** Type Definitions *******************************/
+
+struct ring_segment_t {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t ring_count;
+    uint32_t channels;
+    uint64_t size;                      // size of the whole segment
+    uint64_t offsets[];                 // offset of every ring from the segment start
+};
+
+struct shm_ring_t {
+    uint32_t kind;                      // ring_kind_e
+    uint32_t record_words;              // 64-bit words per record
+    uint32_t capacity;                  // slots, power of two
+    uint32_t channels;                  // values per tick record
+    uint8_t reserved[48];
+    _Atomic uint64_t head;              // number of records published
+    uint8_t padding[56];
+    _Atomic uint64_t slots[];
+};
+
+struct ring_consumer_t {
+    struct ring_segment_t *segment;
+    struct shm_ring_t *ring;
+    uint64_t position;                  // sequence of the next record to read
+    uint64_t lost;                      // records overwritten before they were read
+};
+
+/************************** Variable Definitions *****************************/
+
+extern struct ring_segment_t *client_rings;    // NULL if not published
+
+/************************** Function Prototypes ******************************/
+
+int initRings(uint32_t channels, uint32_t sample_rings);
+void closeRings(void);
+struct shm_ring_t* getRing(struct ring_segment_t *segment, uint32_t index);
+void publishTick(int64_t timestamp, const struct sample_t *values);
+void publishRawSample(struct shm_ring_t *ring, uint32_t channel, struct sample_t sample, uint64_t rx_ns);
+
+int openRingConsumer(struct ring_consumer_t *consumer, int pid, uint32_t index, int from_oldest);
+int readRing(struct ring_consumer_t *consumer, uint64_t *record);
+void closeRingConsumer(struct ring_consumer_t *consumer);
+
+#endif /* __SHM_RING_H__ */
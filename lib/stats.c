@@ -0,0 +1,319 @@
+/*****************************************************************************/
+/**
+*  Brief: 	Contains implementation of the hot-path metrics block.
+*
+*  Created: 16.10.2026
+*  Author: 	Yurii Shenbor
+*
+******************************************************************************/
+
+/***************************** Include Files ********************************/
+
+#include "stats.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/************************** Variable Definitions *****************************/
+
+struct stats_t *client_stats = NULL;
+
+static size_t stats_size = 0;
+static char stats_name[64];
+
+/**************************************************************************/
+/**
+*
+* @brief    Creates the metrics block of the process in shared memory
+*
+* @param	port_count - number of ports to keep metrics for
+* @param	tick_period_ns - configured tick period
+*
+* @return	0 on success, otherwise -1
+*
+* @note		The block is published as /dev/shm/tcp_port_reader.<pid>.
+*
+**************************************************************************/
+int initStats(size_t port_count, uint64_t tick_period_ns) {
+    snprintf(stats_name, sizeof(stats_name), STATS_SHM_PREFIX "%d", (int)getpid());
+    stats_size = sizeof(struct stats_t) + port_count * sizeof(struct port_stats_t);
+
+    int fd = shm_open(stats_name, O_CREAT | O_RDWR | O_TRUNC, 0644);
+    if (fd < 0) {
+        return -1;
+    }
+    if (ftruncate(fd, stats_size) < 0) {
+        close(fd);
+        shm_unlink(stats_name);
+        return -1;
+    }
+
+    struct stats_t *stats = mmap(NULL, stats_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (stats == MAP_FAILED) {
+        shm_unlink(stats_name);
+        return -1;
+    }
+
+    // The segment is zeroed by ftruncate, only the header is filled
+    stats->version = STATS_VERSION;
+    stats->pid = getpid();
+    stats->port_count = port_count;
+    stats->tick_period_ns = tick_period_ns;
+    atomic_thread_fence(memory_order_release);
+    stats->magic = STATS_MAGIC;
+
+    client_stats = stats;
+    return 0;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Removes the metrics block of the process
+*
+* @param	None
+*
+* @return	None
+*
+* @note		None
+*
+**************************************************************************/
+void closeStats(void) {
+    if (client_stats == NULL) {
+        return;
+    }
+
+    munmap(client_stats, stats_size);
+    shm_unlink(stats_name);
+    client_stats = NULL;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Maps the metrics block of another process for reading
+*
+* @param	pid - process id of the client
+* @param	[out] size - size of the mapping
+*
+* @return	the block, NULL if it doesn't exist or is not valid
+*
+* @note		Release the block with munmap.
+*
+**************************************************************************/
+struct stats_t* mapStats(int pid, size_t *size) {
+    char name[64];
+    struct stat info;
+
+    snprintf(name, sizeof(name), STATS_SHM_PREFIX "%d", pid);
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        return NULL;
+    }
+    if (fstat(fd, &info) < 0 || (size_t)info.st_size < sizeof(struct stats_t)) {
+        close(fd);
+        return NULL;
+    }
+
+    struct stats_t *stats = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (stats == MAP_FAILED) {
+        return NULL;
+    }
+
+    if (stats->magic != STATS_MAGIC || stats->version != STATS_VERSION ||
+        sizeof(struct stats_t) + stats->port_count * sizeof(struct port_stats_t) > (size_t)info.st_size) {
+        munmap(stats, info.st_size);
+        return NULL;
+    }
+
+    *size = info.st_size;
+    return stats;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Gets the value below which the given share of a histogram lies
+*
+* @param	histogram - the histogram
+* @param	percentile - 0 ... 100
+*
+* @return	upper bound of the bucket, 0 if nothing was counted
+*
+* @note		Buckets are powers of two, so the value is within 2x.
+*
+**************************************************************************/
+uint64_t statsPercentile(const struct stats_histogram_t *histogram, double percentile) {
+    uint64_t count = 0, seen = 0;
+
+    for (int i = 0; i < STATS_BUCKETS; ++i) {
+        count += atomic_load_explicit(&histogram->buckets[i], memory_order_relaxed);
+    }
+    uint64_t rank = (uint64_t)(percentile / 100.0 * count + 0.5);
+    if (count == 0) {
+        return 0;
+    }
+
+    for (int i = 0; i < STATS_BUCKETS; ++i) {
+        seen += atomic_load_explicit(&histogram->buckets[i], memory_order_relaxed);
+        if (seen >= rank && seen > 0) {
+            uint64_t bound = (i == 0) ? 0 : (i >= 64 ? UINT64_MAX : (1ull << i) - 1);
+            uint64_t max = atomic_load_explicit(&histogram->max, memory_order_relaxed);
+            return (bound < max) ? bound : max;
+        }
+    }
+
+    return atomic_load_explicit(&histogram->max, memory_order_relaxed);
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Accounts a finished tick
+*
+* @param	start_ns - monotonic time the tick started
+* @param	expirations - timer expirations reported for the tick, more than one means overrun
+*
+* @return	None
+*
+* @note		Does nothing if metrics are disabled.
+*
+**************************************************************************/
+void recordTick(uint64_t start_ns, uint64_t expirations) {
+    if (client_stats == NULL) {
+        return;
+    }
+
+    statsAdd(&client_stats->ticks, 1);
+    if (expirations > 1) {
+        statsAdd(&client_stats->overruns, expirations - 1);
+    }
+    statsRecord(&client_stats->tick_ns, monotonicNs() - start_ns);
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Accounts the delay of a tick behind its deadline
+*
+* @param	lag_ns - time from the deadline to the wakeup of the tick loop
+*
+* @return	None
+*
+* @note		None
+*
+**************************************************************************/
+void recordTickLag(uint64_t lag_ns) {
+    if (client_stats == NULL) {
+        return;
+    }
+
+    statsRecord(&client_stats->tick_lag_ns, lag_ns);
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Counts a value in a histogram that may have several writers
+*
+* @param	histogram - the histogram
+* @param	value - the value
+*
+* @return	None
+*
+* @note		None
+*
+**************************************************************************/
+static void recordShared(struct stats_histogram_t *histogram, uint64_t value) {
+    uint32_t bucket = value ? 64 - __builtin_clzll(value) : 0;
+
+    atomic_fetch_add_explicit(&histogram->buckets[bucket < STATS_BUCKETS ? bucket : STATS_BUCKETS - 1], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&histogram->count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&histogram->sum, value, memory_order_relaxed);
+
+    uint64_t max = atomic_load_explicit(&histogram->max, memory_order_relaxed);
+    while (value > max && !atomic_compare_exchange_weak_explicit(&histogram->max, &max, value,
+                                                                 memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Accounts a control message send
+*
+* @param	start_ns - monotonic time the send started
+* @param	failed - nonzero if the message could not be sent
+*
+* @return	None
+*
+* @note		Messages may be sent from several threads, so the counters are
+*           updated with atomic adds. Does nothing if metrics are disabled.
+*
+**************************************************************************/
+void recordSend(uint64_t start_ns, int failed) {
+    if (client_stats == NULL) {
+        return;
+    }
+
+    atomic_fetch_add_explicit(failed ? &client_stats->send_errors : &client_stats->messages, 1, memory_order_relaxed);
+    recordShared(&client_stats->send_ns, monotonicNs() - start_ns);
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Accounts the read-back of a control write
+*
+* @param	rtt_ns - time from the write to the read-back reply, 0 for a timeout
+* @param	result - outcome of the read-back
+*
+* @return	None
+*
+* @note		Does nothing if metrics are disabled.
+*
+**************************************************************************/
+void recordAck(uint64_t rtt_ns, enum ack_result_e result) {
+    if (client_stats == NULL) {
+        return;
+    }
+
+    switch (result) {
+    case ACK_CONFIRMED:
+        atomic_fetch_add_explicit(&client_stats->acks, 1, memory_order_relaxed);
+        break;
+    case ACK_MISMATCH:
+        atomic_fetch_add_explicit(&client_stats->ack_mismatches, 1, memory_order_relaxed);
+        break;
+    case ACK_TIMEOUT:
+        atomic_fetch_add_explicit(&client_stats->ack_timeouts, 1, memory_order_relaxed);
+        return;
+    }
+    recordShared(&client_stats->ack_ns, rtt_ns);
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Accounts control writes sent in reaction to a sample
+*
+* @param	arrival_ns - monotonic time the sample was received
+*
+* @return	None
+*
+* @note		Rules may be evaluated on several reader threads. Does nothing if
+*           metrics are disabled.
+*
+**************************************************************************/
+void recordReaction(uint64_t arrival_ns) {
+    if (client_stats == NULL) {
+        return;
+    }
+
+    recordShared(&client_stats->react_ns, monotonicNs() - arrival_ns);
+}
@@ -0,0 +1,144 @@
+/*****************************************************************************/
+/**
+*  Brief: 	Contains definition for the hot-path metrics block. The block lives in
+*           a POSIX shared memory segment (/dev/shm/tcp_port_reader.<pid>), so it
+*           can be read by another process while the client runs.
+*
+*           Every counter has a single writer (the thread that owns the port or
+*           the tick), so updates are plain relaxed loads and stores without
+*           locks or atomic read-modify-write. Only control counters may be updated
+*           from several threads and use relaxed fetch-and-add.
+*
+*  Created: 16.10.2026
+*  Author: 	Yurii Shenbor
+*
+******************************************************************************/
+
+#ifndef __STATS_H__
+#define __STATS_H__
+
+/***************************** Include Files ********************************/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include <time.h>
+
+/************************** Constant Definitions *****************************/
+
+#define STATS_MAGIC         0x53545052u         // "RPTS"
+#define STATS_VERSION       5
+#define STATS_SHM_PREFIX    "/tcp_port_reader."
+#define STATS_BUCKETS       64                  // Bucket i counts values in [2^(i-1), 2^i), bucket 0 counts 0
+
+/**************************** Type Definitions *******************************/
+
+enum ack_result_e {
+    ACK_CONFIRMED,      // the property reads back the written value
+    ACK_MISMATCH,       // the property reads back another value
+    ACK_TIMEOUT         // no reply in time
+};
+
+// Power of two histogram of durations in nanoseconds
+struct stats_histogram_t {
+    _Atomic uint64_t count;
+    _Atomic uint64_t sum;
+    _Atomic uint64_t max;
+    _Atomic uint64_t buckets[STATS_BUCKETS];
+};
+
+struct port_stats_t {
+    _Atomic uint64_t bytes;             // bytes received
+    _Atomic uint64_t reads;             // receive calls (or completions) with data
+    _Atomic uint64_t samples;           // valid samples framed
+    _Atomic uint64_t missing;           // ticks without a new sample ("--" substitutions)
+    _Atomic uint64_t closed;            // connection closed or failed
+    struct stats_histogram_t read_ns;   // time to receive and frame the data of a read
+    _Atomic uint64_t periods;           // signal periods measured by the estimator
+    _Atomic uint64_t period_ns;         // length of the last period, 0 if the signal does not oscillate
+    _Atomic uint64_t amplitude;         // largest absolute value in the last period, tenths of a volt
+    _Atomic uint64_t shape;             // enum signal_shape_e of the last period
+};
+
+struct stats_t {
+    uint32_t magic;
+    uint32_t version;
+    int32_t pid;
+    uint32_t port_count;
+    uint64_t tick_period_ns;
+    _Atomic uint64_t ticks;
+    _Atomic uint64_t overruns;          // timer expirations missed by the tick loop
+    struct stats_histogram_t tick_ns;   // processing time of a tick
+    struct stats_histogram_t tick_lag_ns;   // time from the deadline of a tick to its start
+    _Atomic uint64_t messages;          // control messages sent
+    _Atomic uint64_t send_errors;       // control messages that could not be sent
+    struct stats_histogram_t send_ns;   // time of a send call
+    _Atomic uint64_t acks;              // control writes confirmed by a read-back
+    _Atomic uint64_t ack_mismatches;    // control writes read back with another value
+    _Atomic uint64_t ack_timeouts;      // control writes without a read-back reply
+    struct stats_histogram_t ack_ns;    // time from a write to its read-back reply
+    struct stats_histogram_t react_ns;  // time from the arrival of a sample to its control writes being sent
+    struct port_stats_t ports[];
+};
+
+/************************** Variable Definitions *****************************/
+
+extern struct stats_t *client_stats;    // NULL if metrics are disabled
+
+/************************** Function Prototypes ******************************/
+
+int initStats(size_t port_count, uint64_t tick_period_ns);
+void closeStats(void);
+struct stats_t* mapStats(int pid, size_t *size);
+void recordTick(uint64_t start_ns, uint64_t expirations);
+void recordTickLag(uint64_t lag_ns);
+void recordSend(uint64_t start_ns, int failed);
+void recordAck(uint64_t rtt_ns, enum ack_result_e result);
+void recordReaction(uint64_t arrival_ns);
+uint64_t statsPercentile(const struct stats_histogram_t *histogram, double percentile);
+
+/**************************************************************************/
+/**
+*
+* @brief    Gets the monotonic time in nanoseconds
+*
+* @note		clock_gettime is served by the vDSO, no syscall is made.
+*
+**************************************************************************/
+static inline uint64_t monotonicNs(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + now.tv_nsec;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Adds to a counter that has a single writer
+*
+* @note		A plain load and store, a concurrent reader sees either value.
+*
+**************************************************************************/
+static inline void statsAdd(_Atomic uint64_t *counter, uint64_t value) {
+    atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + value, memory_order_relaxed);
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Counts a value in a histogram that has a single writer
+*
+**************************************************************************/
+static inline void statsRecord(struct stats_histogram_t *histogram, uint64_t value) {
+    uint32_t bucket = value ? 64 - __builtin_clzll(value) : 0;
+
+    statsAdd(&histogram->buckets[bucket < STATS_BUCKETS ? bucket : STATS_BUCKETS - 1], 1);
+    statsAdd(&histogram->count, 1);
+    statsAdd(&histogram->sum, value);
+    if (value > atomic_load_explicit(&histogram->max, memory_order_relaxed)) {
+        atomic_store_explicit(&histogram->max, value, memory_order_relaxed);
+    }
+}
+
+#endif /* __STATS_H__ */
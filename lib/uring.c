@@ -0,0 +1,485 @@
+/*****************************************************************************/
+/**
+*  Brief: 	Contains implementation of the io_uring receive backend of the event loop.
+*           Every port is served by a single multishot recv, received data is placed
+*           by the kernel into a registered ring of provided buffers and framed in place.
+*
+*  Created: 16.10.2026
+*  Author: 	Yurii Shenbor
+*
+******************************************************************************/
+
+/***************************** Include Files ********************************/
+
+#include "uring.h"
+#include "stats.h"
+
+#ifdef HAVE_IO_URING
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <poll.h>
+#include <signal.h>
+
+/**************************** Type Definitions *******************************/
+
+struct uring_t {
+    int fd;
+    unsigned sq_entries;
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    void *ring_ptr;                     // shared mapping of the SQ and CQ rings
+    size_t ring_size;
+    size_t sqes_size;
+    unsigned pending;                   // queued submissions not passed to the kernel yet
+    struct io_uring_buf_ring *buf_ring; // provided buffer ring shared with the kernel
+    size_t buf_ring_size;
+    char *buffers;
+    unsigned buf_count;
+    uint16_t buf_tail;
+};
+
+/************************** Function Prototypes ******************************/
+
+static int enterUring(struct uring_t *ring, unsigned min_complete, int timeout_ms);
+static struct io_uring_sqe* getSqe(struct uring_t *ring);
+static void commitSqe(struct uring_t *ring);
+static void armRecv(struct uring_t *ring, int sockfd, uint32_t index);
+static void armTimer(struct uring_t *ring, int timerfd, uint32_t index);
+static void recycleBuffer(struct uring_t *ring, uint16_t bid);
+
+/**************************************************************************/
+/**
+*
+* @brief    Submits queued requests and optionally waits for completions
+*
+* @param	ring - io_uring instance
+* @param	min_complete - number of completions to wait for, 0 to submit only
+* @param	timeout_ms - maximum time to wait, -1 to wait forever
+*
+* @return	result of io_uring_enter
+*
+* @note		None
+*
+**************************************************************************/
+static int enterUring(struct uring_t *ring, unsigned min_complete, int timeout_ms) {
+    unsigned flags = (min_complete > 0) ? IORING_ENTER_GETEVENTS : 0;
+    struct __kernel_timespec ts = {timeout_ms / 1000, (timeout_ms % 1000) * 1000000L};
+    struct io_uring_getevents_arg arg = {.sigmask_sz = _NSIG / 8, .ts = (uintptr_t)&ts};
+    void *argp = NULL;
+    size_t argsz = 0;
+
+    if (min_complete > 0 && timeout_ms >= 0) {
+        flags |= IORING_ENTER_EXT_ARG;
+        argp = &arg;
+        argsz = sizeof(arg);
+    }
+
+    int status = syscall(__NR_io_uring_enter, ring->fd, ring->pending, min_complete, flags, argp, argsz);
+    if (status >= 0) {
+        ring->pending -= status;
+    }
+    return status;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Takes the next free submission queue entry
+*
+* @param	ring - io_uring instance
+*
+* @return	a pointer to the cleared entry
+*
+* @note		Submits queued requests first if the queue is full.
+*
+**************************************************************************/
+static struct io_uring_sqe* getSqe(struct uring_t *ring) {
+    unsigned tail = *ring->sq_tail;
+
+    while (tail - atomic_load_explicit((_Atomic unsigned *)ring->sq_head, memory_order_acquire) >= ring->sq_entries) {
+        if (enterUring(ring, 0, -1) < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+            error_exit("io_uring submit failed");
+        }
+    }
+
+    unsigned index = tail & *ring->sq_mask;
+    struct io_uring_sqe *sqe = &ring->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    ring->sq_array[index] = index;
+    return sqe;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Passes the entry taken by getSqe() to the submission queue
+*
+* @param	ring - io_uring instance
+*
+* @return	None
+*
+* @note		None
+*
+**************************************************************************/
+static void commitSqe(struct uring_t *ring) {
+    atomic_store_explicit((_Atomic unsigned *)ring->sq_tail, *ring->sq_tail + 1, memory_order_release);
+    ring->pending++;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Queues a multishot recv for the given socket
+*
+* @param	ring - io_uring instance
+* @param	sockfd - socket file descriptor
+* @param	index - index of the port, returned in every completion
+*
+* @return	None
+*
+* @note		The kernel picks a buffer from the provided buffer ring for every completion.
+*
+**************************************************************************/
+static void armRecv(struct uring_t *ring, int sockfd, uint32_t index) {
+    struct io_uring_sqe *sqe = getSqe(ring);
+
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = sockfd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = URING_BUF_GROUP;
+    sqe->user_data = index;
+    commitSqe(ring);
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Queues a multishot poll for the tick timer
+*
+* @param	ring - io_uring instance
+* @param	timerfd - timer file descriptor
+* @param	index - index reserved for the timer
+*
+* @return	None
+*
+* @note		None
+*
+**************************************************************************/
+static void armTimer(struct uring_t *ring, int timerfd, uint32_t index) {
+    struct io_uring_sqe *sqe = getSqe(ring);
+
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = timerfd;
+    sqe->poll32_events = POLLIN;
+    sqe->len = IORING_POLL_ADD_MULTI;
+    sqe->user_data = index;
+    commitSqe(ring);
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Returns a buffer to the provided buffer ring
+*
+* @param	ring - io_uring instance
+* @param	bid - buffer id
+*
+* @return	None
+*
+* @note		The kernel sees returned buffers after the ring tail is published.
+*
+**************************************************************************/
+static void recycleBuffer(struct uring_t *ring, uint16_t bid) {
+    struct io_uring_buf *buf = &ring->buf_ring->bufs[ring->buf_tail & (ring->buf_count - 1)];
+
+    buf->addr = (uintptr_t)&ring->buffers[(size_t)bid * URING_BUF_SIZE];
+    buf->len = URING_BUF_SIZE;
+    buf->bid = bid;
+    ring->buf_tail++;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Creates an io_uring instance for the event loop
+*
+* @param	loop - event loop with ports and timer already set
+*
+* @return	0 on success, -1 if io_uring is not available
+*
+* @note		On failure nothing is left allocated and the caller falls back to epoll.
+*
+**************************************************************************/
+int initUring(struct event_loop_t *loop) {
+    struct io_uring_params params;
+    struct uring_t *ring = calloc(1, sizeof(*ring));
+
+    if (ring == NULL) {
+        return -1;
+    }
+
+    // Two buffers per port let a port keep receiving while its previous data is framed
+    ring->buf_count = URING_BUF_MIN;
+    while (ring->buf_count < (unsigned)loop->port_count * 2 && ring->buf_count < URING_BUF_MAX) {
+        ring->buf_count *= 2;
+    }
+
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_COOP_TASKRUN;
+    params.cq_entries = (ring->buf_count > URING_SQ_ENTRIES) ? ring->buf_count * 2 : URING_SQ_ENTRIES * 2;
+    ring->fd = syscall(__NR_io_uring_setup, URING_SQ_ENTRIES, &params);
+    if (ring->fd < 0 && errno == EINVAL) {
+        params.flags &= ~IORING_SETUP_COOP_TASKRUN;
+        ring->fd = syscall(__NR_io_uring_setup, URING_SQ_ENTRIES, &params);
+    }
+    if (ring->fd < 0) {
+        free(ring);
+        return -1;
+    }
+
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP) || !(params.features & IORING_FEAT_EXT_ARG)) {
+        close(ring->fd);
+        free(ring);
+        return -1;
+    }
+
+    // Map the SQ and CQ rings with a single mapping, and the submission entries
+    size_t sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    size_t cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    ring->ring_size = (sq_size > cq_size) ? sq_size : cq_size;
+    ring->ring_ptr = mmap(NULL, ring->ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+
+    // Provided buffer ring, its memory must be page aligned
+    ring->buf_ring_size = ring->buf_count * sizeof(struct io_uring_buf);
+    ring->buf_ring = mmap(NULL, ring->buf_ring_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    ring->buffers = malloc((size_t)ring->buf_count * URING_BUF_SIZE);
+
+    if (ring->ring_ptr == MAP_FAILED || ring->sqes == MAP_FAILED || ring->buf_ring == MAP_FAILED || ring->buffers == NULL) {
+        loop->uring = ring;
+        closeUring(loop);
+        return -1;
+    }
+
+    char *ptr = ring->ring_ptr;
+    ring->sq_entries = params.sq_entries;
+    ring->sq_head = (unsigned *)(ptr + params.sq_off.head);
+    ring->sq_tail = (unsigned *)(ptr + params.sq_off.tail);
+    ring->sq_mask = (unsigned *)(ptr + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned *)(ptr + params.sq_off.array);
+    ring->cq_head = (unsigned *)(ptr + params.cq_off.head);
+    ring->cq_tail = (unsigned *)(ptr + params.cq_off.tail);
+    ring->cq_mask = (unsigned *)(ptr + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)(ptr + params.cq_off.cqes);
+
+    struct io_uring_buf_reg reg = {
+        .ring_addr = (uintptr_t)ring->buf_ring,
+        .ring_entries = ring->buf_count,
+        .bgid = URING_BUF_GROUP
+    };
+    if (syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        loop->uring = ring;
+        closeUring(loop);
+        return -1;
+    }
+
+    for (unsigned bid = 0; bid < ring->buf_count; ++bid) {
+        recycleBuffer(ring, bid);
+    }
+    atomic_store_explicit((_Atomic uint16_t *)&ring->buf_ring->tail, ring->buf_tail, memory_order_release);
+
+    loop->uring = ring;
+
+    if (loop->timerfd >= 0) {
+        armTimer(ring, loop->timerfd, loop->port_count);
+    }
+    for (int i = 0; i < loop->port_count; ++i) {
+        if (loop->ports[i].state != PORT_DISCONNECTED) {
+            watchUringPort(loop, i);
+        }
+    }
+
+    if (enterUring(ring, 0, -1) < 0) {
+        closeUring(loop);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Waits for completions and consumes data received by the ports
+*
+* @param	loop - event loop
+* @param	timeout_ms - maximum time to wait, -1 to wait forever
+*
+* @return	number of tick periods elapsed, 0 if the timer has not expired
+*
+* @note		Queued submissions and the wait are done with a single io_uring_enter call.
+*
+**************************************************************************/
+uint64_t dispatchUring(struct event_loop_t *loop, int timeout_ms) {
+    struct uring_t *ring = loop->uring;
+    uint64_t expirations = 0;
+    unsigned head = *ring->cq_head;
+
+    if (head == atomic_load_explicit((_Atomic unsigned *)ring->cq_tail, memory_order_acquire)) {
+        if (enterUring(ring, 1, timeout_ms) < 0 && errno != EINTR && errno != ETIME && errno != EAGAIN && errno != EBUSY) {
+            error_exit("io_uring wait failed");
+        }
+    }
+
+    unsigned tail = atomic_load_explicit((_Atomic unsigned *)ring->cq_tail, memory_order_acquire);
+    for (; head != tail; ++head) {
+        struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cq_mask];
+        uint32_t index = (uint32_t)cqe->user_data;
+        int more = cqe->flags & IORING_CQE_F_MORE;
+
+        if (cqe->user_data & URING_CONNECT_TAG) {
+            if (finishConnect(&loop->ports[index]) < 0) {
+                loop->waiting++;
+            } else {
+                armRecv(ring, loop->ports[index].sockfd, index);
+            }
+            continue;
+        }
+
+        if (index == (uint32_t)loop->port_count) {
+            uint64_t count;
+            if (read(loop->timerfd, &count, sizeof(count)) == sizeof(count)) {
+                expirations += count;
+            }
+            if (!more) {
+                armTimer(ring, loop->timerfd, index);
+            }
+            continue;
+        }
+
+        struct port_t *port = &loop->ports[index];
+        if (cqe->res > 0 && (cqe->flags & IORING_CQE_F_BUFFER)) {
+            uint16_t bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+            uint64_t start_ns = (port->stats != NULL) ? monotonicNs() : 0;
+            consumeData(port, &ring->buffers[(size_t)bid * URING_BUF_SIZE], cqe->res);
+            recycleBuffer(ring, bid);
+            if (port->stats != NULL) {
+                statsRecord(&port->stats->read_ns, monotonicNs() - start_ns);
+            }
+        }
+
+        if (!more) {
+            if (cqe->res > 0 || cqe->res == -ENOBUFS) {
+                // Multishot stopped but the socket is fine, start it again
+                armRecv(ring, port->sockfd, index);
+            } else if (cqe->res != -ECANCELED) {
+                dropConnection(loop, index);
+            }
+        }
+    }
+
+    atomic_store_explicit((_Atomic unsigned *)ring->cq_head, head, memory_order_release);
+    atomic_store_explicit((_Atomic uint16_t *)&ring->buf_ring->tail, ring->buf_tail, memory_order_release);
+
+    return expirations;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Starts serving a port that got a new socket
+*
+* @param	loop - event loop
+* @param	index - index of the port in the loop
+*
+* @return	None
+*
+* @note		A connecting socket is polled for writability first, its completion
+*           carries URING_CONNECT_TAG, then the multishot recv is queued.
+*
+**************************************************************************/
+void watchUringPort(struct event_loop_t *loop, uint32_t index) {
+    struct port_t *port = &loop->ports[index];
+
+    if (port->state != PORT_CONNECTING) {
+        armRecv(loop->uring, port->sockfd, index);
+        return;
+    }
+
+    struct io_uring_sqe *sqe = getSqe(loop->uring);
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = port->sockfd;
+    sqe->poll32_events = POLLOUT;
+    sqe->user_data = URING_CONNECT_TAG | index;
+    commitSqe(loop->uring);
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Releases the io_uring instance of the event loop
+*
+* @param	loop - event loop
+*
+* @return	None
+*
+* @note		None
+*
+**************************************************************************/
+void closeUring(struct event_loop_t *loop) {
+    struct uring_t *ring = loop->uring;
+
+    if (ring == NULL) {
+        return;
+    }
+
+    if (ring->buffers != NULL) {
+        free(ring->buffers);
+    }
+    if (ring->buf_ring != NULL && ring->buf_ring != MAP_FAILED) {
+        munmap(ring->buf_ring, ring->buf_ring_size);
+    }
+    if (ring->sqes != NULL && ring->sqes != MAP_FAILED) {
+        munmap(ring->sqes, ring->sqes_size);
+    }
+    if (ring->ring_ptr != NULL && ring->ring_ptr != MAP_FAILED) {
+        munmap(ring->ring_ptr, ring->ring_size);
+    }
+    close(ring->fd);
+    free(ring);
+    loop->uring = NULL;
+}
+
+#else
+
+/**************************************************************************/
+/**
+*
+* @brief    Stub used when the io_uring backend is not built in
+*
+**************************************************************************/
+int initUring(struct event_loop_t *loop) {
+    return -1;
+}
+
+uint64_t dispatchUring(struct event_loop_t *loop, int timeout_ms) {
+    return 0;
+}
+
+void closeUring(struct event_loop_t *loop) {
+}
+
+void watchUringPort(struct event_loop_t *loop, uint32_t index) {
+}
+
+#endif /* HAVE_IO_URING */
@@ -0,0 +1,40 @@
+/*****************************************************************************/
+/**
+*  Brief: 	Contains definition for the io_uring receive backend of the event loop.
+*
+*  Created: 16.10.2026
+*  Author: 	Yurii Shenbor
+*
+******************************************************************************/
+
+#ifndef __URING_H__
+#define __URING_H__
+
+/***************************** Include Files ********************************/
+
+#include "client_lib.h"
+
+#if defined(USE_IO_URING) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#if defined(IORING_RECV_MULTISHOT)
+#define HAVE_IO_URING   1
+#endif
+#endif
+
+/************************** Constant Definitions *****************************/
+
+#define URING_SQ_ENTRIES    256     // Submission queue size
+#define URING_BUF_SIZE      1024    // Size of every provided receive buffer
+#define URING_BUF_MIN       64      // Minimum number of provided buffers per loop
+#define URING_BUF_MAX       32768   // Maximum number of provided buffers per loop
+#define URING_BUF_GROUP     0       // Buffer group id of the provided buffer ring
+#define URING_CONNECT_TAG   (1ull << 32)    // Marks completions of a pending connect in user_data
+
+/************************** Function Prototypes ******************************/
+
+int initUring(struct event_loop_t *loop);
+uint64_t dispatchUring(struct event_loop_t *loop, int timeout_ms);
+void watchUringPort(struct event_loop_t *loop, uint32_t index);
+void closeUring(struct event_loop_t *loop);
+
+#endif /* __URING_H__ */
@@ -1,6 +1,7 @@
 /*****************************************************************************/
 /**
-*  Brief: 	Reads data from TCP ports 4001 ... 4003 and prints it to standard output.
+*  Brief: 	Reads data from TCP ports 4001 ... 4003 (or the given channels) and prints it
+*           to standard output.
 *
 *  Created: 28.09.2024
 *  Author: 	Yurii Shenbor
@@ -10,6 +11,9 @@
 /***************************** Include Files ********************************/
 
 #include "../lib/client_lib.h"
+#include "../lib/channels.h"
+#include "../lib/output.h"
+#include "../lib/bin_log.h"
 
 /************************** Constant Definitions *****************************/
 
@@ -30,12 +34,21 @@
 *
 **************************************************************************/
 int main(int argc, char *argv[]) {
-    struct port_t ports[MAX_PORTS];
+    struct client_options_t options = {.tick_ms = TIMEOUT_MS};
+    struct channel_table_t table;
+    struct output_t output;
+    struct bin_log_t bin_log;
+    struct event_loop_t loop;
     struct timeval time;
-    unsigned long int target_time_msec = 0, current_time_msec;
-    int port;
+    unsigned long int current_time_msec;
+    unsigned ticks = 0;
     FILE *out = stdout;
 
+    initChannelTable(&table);
+    if (parseClientOptions(argc, argv, &options, &table) < 0) {
+        exit(EXIT_FAILURE);
+    }
+
 #ifdef PRINT_TO_FILE
     out = fopen("logs/client1.log", "w");
     if (!out) {
@@ -43,36 +56,70 @@ int main(int argc, char *argv[]) {
     }
 #endif
 
-    for (port = 0; port < MAX_PORTS; port++) {
-        struct sockaddr_in server_addr;
-        if (findOpenPort(port + TCP_PORT, &server_addr) < 0) {
-            error_exit("An open port could not be found");
-        }
-        
-        // printf("Connecting to port %d...\n", port + TCP_PORT);
-        ports[port].sockfd = connectToPort(&server_addr, 25000);
+    if (options.stats && initStats(table.count, options.tick_ms * 1000000) < 0) {
+        error_exit("Unable to publish metrics");
+    }
+
+    connectChannels(&table);
+
+    // Raw samples go to one ring per thread that reads the channels
+    if (options.rings && initRings(table.count, (options.rings > 1) ? 1 : 0) < 0) {
+        error_exit("Unable to publish rings");
+    }
+    attachRings(&table, 1);
+
+    if (initOutput(&output, fileno(out), table.count, options.flush_lines, options.flush_ms) < 0) {
+        error_exit("Unable to allocate output");
+    }
+    if (options.aggregates && enableOutputAggregates(&output, options.aggregates) < 0) {
+        error_exit("Unable to allocate output");
+    }
+    if (options.binary_log && openBinLog(&bin_log, options.binary_log, table.count, CLIENT_LOG_ROWS, 0) < 0) {
+        error_exit("Unable to open binary log");
+    }
+
+    if (initEventLoop(&loop, table.ports, table.count, options.tick_ms) < 0) {
+        error_exit("Unable to start event loop");
+    }
+    if (options.realtime) {
+        enableRealtime(options.realtime_cpu);
     }
 
     while (1) {
+        // Data from all channels is consumed as it arrives, the tick only prints it
+        uint64_t expirations = waitForTick(&loop);
+        uint64_t tick_start_ns = monotonicNs();
+
         gettimeofday(&time, NULL);
         current_time_msec = ((unsigned long int)time.tv_sec * 1000) + ((unsigned long int)time.tv_usec / 1000);
 
-        if (current_time_msec >= target_time_msec) {
-            target_time_msec = current_time_msec + TIMEOUT_MS;
-
-            // Read all ports, starting with the slowest one
-            for (port = MAX_PORTS; port >= 0; --port) {
-                readFromPort(&ports[port]);
+        snapshotChannels(&table);
+        // With decimation a line covers several ticks, aggregates span all of them
+        if (++ticks >= options.decimation) {
+            ticks = 0;
+            if (options.aggregates) {
+                closeAggregates(&table);
+                writeAggregates(&output, current_time_msec, table.aggregated);
+            } else {
+                writeTick(&output, current_time_msec, table.values);
             }
-
-            fprintf(out, "{\"timestamp\": %lu, \"out1\": \"%s\", \"out2\": \"%s\", \"out3\": \"%s\"}\n",
-                    current_time_msec, ports[0].data_ptr, ports[1].data_ptr, ports[2].data_ptr);
         }
+        expireOutput(&output, current_time_msec);
+        if (options.binary_log && appendBinLog(&bin_log, current_time_msec, table.values) < 0) {
+            error_exit("Unable to write binary log");
+        }
+        publishTick(current_time_msec, table.values);
+        recordTick(tick_start_ns, expirations);
     }
 
-    for (port = 0; port < MAX_PORTS; port++) {
-        close(ports[port].sockfd);
+    closeEventLoop(&loop);
+    closeOutput(&output);
+    if (options.binary_log) {
+        closeBinLog(&bin_log);
     }
+    freeChannelTable(&table);
+    closeStats();
+    closeRings();
 
 #ifdef PRINT_TO_FILE
     fclose(out);
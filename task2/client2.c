@@ -11,6 +11,10 @@
 /***************************** Include Files ********************************/
 
 #include "../lib/client_lib.h"
+#include "../lib/channels.h"
+#include "../lib/output.h"
+#include "../lib/bin_log.h"
+#include "../lib/rules.h"
 
 /************************** Constant Definitions *****************************/
 
@@ -18,6 +22,42 @@
 
 // #define PRINT_TO_FILE   1   // Uncomment to print to file instead of STDOUT
 
+// When output 3 reaches 3.0 set output 1 to 1Hz and amplitude 8000, below it to 2Hz and amplitude 4000
+static const char *default_rules[] = {
+    "3 >= 3.0 0 0 1.frequency=1000 1.amplitude=8000",
+    "3 <  3.0 0 0 1.frequency=2000 1.amplitude=4000",
+};
+
+/**************************************************************************/
+/**
+*
+* @brief    Loads the control rules of a reactor
+*
+* @param	reactor - reactor with the controls initialized
+* @param	options - client options
+* @param	channel_count - number of channels
+*
+* @return	None
+*
+* @note		Without a rules file the default rules are used if output 3 exists.
+*
+**************************************************************************/
+static void loadControlRules(struct reactor_t *reactor, const struct client_options_t *options, size_t channel_count) {
+    initRules(&reactor->rules, channel_count, reactor->controls, reactor->control_of);
+    if (options->rules) {
+        if (loadRules(&reactor->rules, options->rules) < 0) {
+            exit(EXIT_FAILURE);
+        }
+    } else if (channel_count >= MAX_PORTS) {
+        for (size_t i = 0; i < sizeof(default_rules) / sizeof(default_rules[0]); ++i) {
+            addRule(&reactor->rules, default_rules[i]);
+        }
+    }
+    if (compileRules(&reactor->rules) < 0) {
+        error_exit("Unable to compile rules");
+    }
+}
+
 /**************************************************************************/
 /**
 *
@@ -31,14 +71,24 @@
 *
 **************************************************************************/
 int main(int argc, char *argv[]) {
-    struct port_t ports[MAX_PORTS];
-    pthread_t thread_id[MAX_PORTS];
-    struct sockaddr_in tcp_server_addr, udp_server_addr;
+    struct client_options_t options = {.tick_ms = TIMEOUT_MS, .control = 1};
+    struct channel_table_t table;
+    struct output_t output;
+    struct bin_log_t bin_log;
+    struct event_loop_t loop, *readers;
+    pthread_t *thread_id;
+    struct reactor_t *reactors;
     struct timeval time;
-    unsigned long int target_time_msec = 0, current_time_msec;
-    int port, udp_sokfd;
+    unsigned long int current_time_msec;
+    unsigned ticks = 0;
+    int reader_count, reactor_count;
     FILE *out = stdout;
 
+    initChannelTable(&table);
+    if (parseClientOptions(argc, argv, &options, &table) < 0) {
+        exit(EXIT_FAILURE);
+    }
+
 #ifdef PRINT_TO_FILE
     out = fopen("logs/client2.log", "w");
     if (!out) {
@@ -46,45 +96,111 @@ int main(int argc, char *argv[]) {
     }
 #endif
 
-    for (port = 0; port < MAX_PORTS; port++) {
-        struct sockaddr_in tcp_server_addr;
-        if (findOpenPort(port + TCP_PORT, &tcp_server_addr) < 0) {
-            error_exit("An open port could not be found");
+    if (options.stats && initStats(table.count, options.tick_ms * 1000000) < 0) {
+        error_exit("Unable to publish metrics");
+    }
+
+    connectChannels(&table);
+
+    // Raw samples go to one ring per thread that reads the channels
+    if (options.rings && initRings(table.count, (options.rings > 1) ? options.reader_threads : 0) < 0) {
+        error_exit("Unable to publish rings");
+    }
+    attachRings(&table, options.reader_threads);
+
+    if (initOutput(&output, fileno(out), table.count, options.flush_lines, options.flush_ms) < 0) {
+        error_exit("Unable to allocate output");
+    }
+    if (options.aggregates && enableOutputAggregates(&output, options.aggregates) < 0) {
+        error_exit("Unable to allocate output");
+    }
+    if (options.binary_log && openBinLog(&bin_log, options.binary_log, table.count, CLIENT_LOG_ROWS, 0) < 0) {
+        error_exit("Unable to open binary log");
+    }
+
+    // Control the server on the host of every channel, either on every tick
+    // or on every reader thread as soon as a sample arrives
+    reactor_count = options.react ? options.reader_threads : 1;
+    if ((reactors = calloc(reactor_count, sizeof(*reactors))) == NULL) {
+        error_exit("Calloc failed");
+    }
+    for (int i = 0; i < reactor_count; i++) {
+        if (initReactor(&reactors[i], &table, options.udp_port, options.ack) < 0) {
+            error_exit("Unable to start control");
         }
-        
-        // printf("Connecting to port %d...\n", port + TCP_PORT);
-        ports[port].sockfd = connectToPort(&tcp_server_addr, 10000);
+        loadControlRules(&reactors[i], &options, table.count);
+    }
+    if (options.react) {
+        attachReactors(&table, options.reader_threads, reactors);
     }
 
-    // Start UDP server
-    udp_sokfd = startServer(&tcp_server_addr.sin_addr, UDP_PORT, &udp_server_addr);
+    // Start long-lived reader threads, each one publishes every value of its channels
+    readers = calloc(options.reader_threads, sizeof(*readers));
+    thread_id = calloc(options.reader_threads, sizeof(*thread_id));
+    if (!readers || !thread_id) {
+        error_exit("Calloc failed");
+    }
+    reader_count = startReaders(&table, options.reader_threads, readers, thread_id);
+
+    // The event loop watches only the tick timer, the channels are handled by the readers
+    if (initEventLoop(&loop, NULL, 0, options.tick_ms) < 0) {
+        error_exit("Unable to start event loop");
+    }
+    if (options.realtime) {
+        enableRealtime(options.realtime_cpu);
+    }
 
     while (1) {
+        uint64_t expirations = waitForTick(&loop);
+        uint64_t tick_start_ns = monotonicNs();
+
         gettimeofday(&time, NULL);
         current_time_msec = ((unsigned long int)time.tv_sec * 1000) + ((unsigned long int)time.tv_usec / 1000);
 
-        if (current_time_msec >= target_time_msec) {
-            target_time_msec = current_time_msec + TIMEOUT_MS;
+        // Take the latest value of every channel without waiting for the readers
+        snapshotChannels(&table);
 
-            // Spawn threads to read from multiple ports simultaneously
-            for (port = MAX_PORTS; port >= 0; --port) {
-                pthread_create(&thread_id[port], NULL, readFromPortInThread, (void *)&ports[port]);
+        if (!options.react) {
+            applyRules(&reactors[0].rules, table.values, tick_start_ns);
+            pollReactor(&reactors[0]);
+        }
+        // With decimation a line covers several ticks, aggregates span all of them
+        if (++ticks >= options.decimation) {
+            ticks = 0;
+            if (options.aggregates) {
+                closeAggregates(&table);
+                writeAggregates(&output, current_time_msec, table.aggregated);
+            } else {
+                writeTick(&output, current_time_msec, table.values);
             }
-
-            pthread_join(thread_id[0], NULL);
-            pthread_join(thread_id[1], NULL);
-            pthread_join(thread_id[2], NULL);
-            
-            changeBehavior(ports[2].data_ptr, udp_sokfd, &udp_server_addr);
-            fprintf(out, "{\"timestamp\": %lu, \"out1\": \"%s\", \"out2\": \"%s\", \"out3\": \"%s\"}\n",
-                    current_time_msec, ports[0].data_ptr, ports[1].data_ptr, ports[2].data_ptr);
         }
+        expireOutput(&output, current_time_msec);
+        if (options.binary_log && appendBinLog(&bin_log, current_time_msec, table.values) < 0) {
+            error_exit("Unable to write binary log");
+        }
+        publishTick(current_time_msec, table.values);
+        recordTick(tick_start_ns, expirations);
     }
 
-    for (port = 0; port < MAX_PORTS; port++) {
-        close(ports[port].sockfd);
+    closeEventLoop(&loop);
+    for (int i = 0; i < reader_count; i++) {
+        pthread_join(thread_id[i], NULL);
+        closeEventLoop(&readers[i]);
+    }
+    free(readers);
+    free(thread_id);
+    closeOutput(&output);
+    if (options.binary_log) {
+        closeBinLog(&bin_log);
+    }
+    freeChannelTable(&table);
+    closeStats();
+    closeRings();
+    for (int i = 0; i < reactor_count; i++) {
+        freeRules(&reactors[i].rules);
+        closeReactor(&reactors[i]);
     }
-    close(udp_sokfd);
+    free(reactors);
 
 #ifdef PRINT_TO_FILE
     fclose(out);
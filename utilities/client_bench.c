@@ -0,0 +1,787 @@
+/*****************************************************************************/
+/**
+*  Brief: 	End-to-end benchmark of the client apps. Plays the signal server on
+*           loopback, runs client1 and client2 against it and measures the time
+*           from a sample being sent to it appearing in the client output, the
+*           number of channels the tick keeps up with, the CPU time of a tick
+*           and the round trip of the control protocol. Results are written as
+*           a JSON document.
+*
+*           Every sample carries its sequence number in its value: the sign
+*           alternates and the magnitude counts up, so a value identifies the
+*           sample within SEQ_PERIOD samples and the time it was sent is looked
+*           up in a table.
+*
+*  Created: 16.10.2026
+*  Author: 	Yurii Shenbor
+*
+******************************************************************************/
+
+/***************************** Include Files ********************************/
+
+#define _GNU_SOURCE     // accept4
+
+#include "../lib/client_lib.h"
+#include "../lib/control.h"
+#include "../lib/stats.h"
+#include <getopt.h>
+#include <inttypes.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+/************************** Constant Definitions *****************************/
+
+#define SEQ_PERIOD          19998       // Samples with distinct values, "0.1" ... "999.9" and their negatives
+#define SOURCE_TICK_US      1000        // Period of the writes of the source
+#define WRITE_MAX           8192        // Bytes written to a connection per source tick
+#define CONNECT_TIMEOUT_MS  5000        // Time for a client to connect all its channels
+#define WARMUP_MS           500         // Start of a run that is not measured
+#define PASS_DELIVERY       0.98        // Share of the sent samples a passing run must read
+#define PASS_OVERRUNS       0.01        // Share of the ticks a passing run may miss
+#define CHANNEL_STEPS_MAX   16
+#define CONTROL_CHANNELS    4
+#define CONTROL_RULES       "1 >= 0.0 0 10 1.frequency=1000\n" \
+                            "1 <  0.0 0 10 1.frequency=2000\n"
+
+/**************************** Type Definitions *******************************/
+
+struct connection_t {
+    int sockfd;
+    uint32_t partial_size;
+    char partial[SAMPLE_TEXT_SIZE];     // rest of a line the socket did not take
+};
+
+// Plays the signal server, all connections get the same samples
+struct source_t {
+    struct connection_t *connections;
+    size_t count;
+    unsigned long rate;                 // samples per second of every connection
+    uint64_t start_ns;
+    uint64_t produced;
+    _Atomic uint64_t delivered;         // lines taken by all connections
+    atomic_int stop;
+};
+
+// Answers the control protocol, every property reads back its last written value
+struct responder_t {
+    int sockfd;
+    uint16_t port;
+    uint16_t values[4][65536];
+    atomic_int stop;
+};
+
+// Counters of a client at the start and at the end of the measured time
+struct snapshot_t {
+    uint64_t ns;
+    uint64_t ticks;
+    uint64_t overruns;
+    uint64_t samples;
+    uint64_t delivered;
+    double cpu_s;
+};
+
+struct run_t {
+    const char *client;
+    size_t channels;
+    int control;
+    int failed;                         // the client could not be started or connected
+    struct snapshot_t first;
+    struct snapshot_t last;
+    uint64_t *latency_ns;               // latency of every sample value in the output
+    size_t latency_count;
+    size_t latency_capacity;
+    struct stats_histogram_t tick_ns;
+    struct stats_histogram_t tick_lag_ns;
+    struct stats_histogram_t ack_ns;
+    struct stats_histogram_t react_ns;
+    uint64_t acks;
+    uint64_t ack_timeouts;
+};
+
+/************************** Variable Definitions *****************************/
+
+static _Atomic uint64_t emit_ns[SEQ_PERIOD];   // time every sample value was sent last
+static unsigned long sample_rate = 1000;
+static unsigned long tick_ms = 10;
+static unsigned long duration_ms = 2000;
+
+/************************** Function Prototypes ******************************/
+
+static void* runSource(void *args);
+static void* runResponder(void *args);
+static void consumeOutput(struct run_t *run, char *line, uint64_t now_ns);
+static double processCpu(pid_t pid);
+static void takeSnapshot(struct run_t *run, struct snapshot_t *snapshot, pid_t pid, struct source_t *source);
+static int benchClient(struct run_t *run, const char *path, size_t channels, struct responder_t *responder);
+static int compareLatency(const void *a, const void *b);
+static double latencyPercentile(const struct run_t *run, double percentile);
+static int passed(const struct run_t *run);
+static void writeRun(FILE *out, const struct run_t *run);
+
+/**************************************************************************/
+/**
+*
+* @brief    Writes the samples due to all connections once per source tick
+*
+* @param	args - source state
+*
+* @return	None
+*
+* @note		Lines a connection does not take are dropped, except the rest of a
+*           line already started, so the stream stays in real time.
+*
+**************************************************************************/
+static void* runSource(void *args) {
+    struct source_t *source = (struct source_t *)args;
+    char buffer[WRITE_MAX + SAMPLE_TEXT_SIZE];
+    struct itimerspec period = {.it_interval = {0, SOURCE_TICK_US * 1000}, .it_value = {0, SOURCE_TICK_US * 1000}};
+    int timerfd = timerfd_create(CLOCK_MONOTONIC, 0);
+
+    if (timerfd < 0 || timerfd_settime(timerfd, 0, &period, NULL) < 0) {
+        error_exit("Unable to start the source timer");
+    }
+
+    while (!atomic_load(&source->stop)) {
+        uint64_t expirations;
+        if (read(timerfd, &expirations, sizeof(expirations)) < 0) {
+            continue;
+        }
+
+        uint64_t now_ns = monotonicNs();
+        uint64_t due = (now_ns - source->start_ns) / 1000 * source->rate / 1000000;
+        size_t used = 0;
+
+        // Samples are identified by the value: the sign alternates and the magnitude counts up
+        for (; source->produced < due && used < WRITE_MAX; source->produced++) {
+            uint32_t seq = source->produced % SEQ_PERIOD;
+            int32_t value = seq / 2 + 1;
+
+            atomic_store_explicit(&emit_ns[seq], now_ns, memory_order_relaxed);
+            used += formatSample((struct sample_t){(seq & 1) ? -value : value, 1}, &buffer[used]);
+            buffer[used++] = '\n';
+        }
+        source->produced = due;
+
+        uint64_t delivered = 0;
+        for (size_t i = 0; i < source->count; ++i) {
+            struct connection_t *conn = &source->connections[i];
+
+            if (conn->sockfd < 0) {
+                continue;
+            }
+            if (conn->partial_size > 0) {
+                ssize_t sent = send(conn->sockfd, conn->partial, conn->partial_size, MSG_DONTWAIT | MSG_NOSIGNAL);
+                if (sent < (ssize_t)conn->partial_size) {
+                    if (sent > 0) {
+                        memmove(conn->partial, &conn->partial[sent], conn->partial_size - sent);
+                        conn->partial_size -= sent;
+                    }
+                    continue;
+                }
+                conn->partial_size = 0;
+                delivered++;
+            }
+            if (used == 0) {
+                continue;
+            }
+
+            ssize_t sent = send(conn->sockfd, buffer, used, MSG_DONTWAIT | MSG_NOSIGNAL);
+            if (sent <= 0) {
+                if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+                    close(conn->sockfd);
+                    conn->sockfd = -1;
+                }
+                continue;
+            }
+
+            const char *pos = buffer, *end = buffer + sent;
+            while ((pos = memchr(pos, '\n', end - pos)) != NULL) {
+                delivered++;
+                pos++;
+            }
+            if ((size_t)sent < used && buffer[sent - 1] != '\n') {
+                const char *line_end = memchr(end, '\n', used - sent);
+                conn->partial_size = line_end + 1 - end;
+                memcpy(conn->partial, end, conn->partial_size);
+            }
+        }
+        atomic_fetch_add_explicit(&source->delivered, delivered, memory_order_relaxed);
+    }
+
+    close(timerfd);
+    return NULL;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Answers control messages until stopped, in a thread
+*
+* @param	args - responder state
+*
+* @return	None
+*
+* @note		A WRITE stores the value, a READ is answered with the stored value,
+*           like the signal server does for its properties.
+*
+**************************************************************************/
+static void* runResponder(void *args) {
+    struct responder_t *responder = (struct responder_t *)args;
+    uint8_t msg[16];
+    struct sockaddr_in addr;
+
+    while (!atomic_load(&responder->stop)) {
+        socklen_t addr_size = sizeof(addr);
+        ssize_t size = recvfrom(responder->sockfd, msg, sizeof(msg), 0, (struct sockaddr *)&addr, &addr_size);
+        if (size < 6) {
+            continue;
+        }
+
+        uint16_t operation = (msg[0] << 8) | msg[1];
+        uint16_t object = ((msg[2] << 8) | msg[3]) & 3;
+        uint16_t property = (msg[4] << 8) | msg[5];
+        if (operation == WRITE && size >= 8) {
+            responder->values[object][property] = (msg[6] << 8) | msg[7];
+        } else if (operation == READ) {
+            msg[6] = responder->values[object][property] >> 8;
+            msg[7] = responder->values[object][property] & 0xFF;
+            sendto(responder->sockfd, msg, 8, 0, (struct sockaddr *)&addr, addr_size);
+        }
+    }
+
+    return NULL;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Measures the latency of every sample value in an output line
+*
+* @param	run - run being measured
+* @param	line - output line `{"timestamp": T, "out1": "v1", ...}`
+* @param	now_ns - time the line was read
+*
+* @return	None
+*
+* @note		"--" values have no sample and are skipped.
+*
+**************************************************************************/
+static void consumeOutput(struct run_t *run, char *line, uint64_t now_ns) {
+    const char *pos = line;
+
+    while ((pos = strstr(pos, "\"out")) != NULL) {
+        if ((pos = strstr(pos, ": \"")) == NULL) {
+            break;
+        }
+        pos += 3;
+
+        int negative = (*pos == '-');
+        uint32_t value = 0;
+        if (negative) {
+            pos++;
+        }
+        if (*pos < '0' || *pos > '9') {
+            continue;
+        }
+        while ((*pos >= '0' && *pos <= '9') || *pos == '.') {
+            if (*pos != '.') {
+                value = value * 10 + (*pos - '0');
+            }
+            pos++;
+        }
+        if (value == 0 || value > SEQ_PERIOD / 2) {
+            continue;
+        }
+
+        uint64_t sent_ns = atomic_load_explicit(&emit_ns[2 * (value - 1) + negative], memory_order_relaxed);
+        if (sent_ns == 0 || sent_ns > now_ns) {
+            continue;
+        }
+        if (run->latency_count == run->latency_capacity) {
+            size_t capacity = run->latency_capacity ? run->latency_capacity * 2 : 4096;
+            void *ptr = realloc(run->latency_ns, capacity * sizeof(*run->latency_ns));
+            if (ptr == NULL) {
+                error_exit("Unable to grow latencies");
+            }
+            run->latency_ns = ptr;
+            run->latency_capacity = capacity;
+        }
+        run->latency_ns[run->latency_count++] = now_ns - sent_ns;
+    }
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Gets the CPU time used by a process
+*
+* @param	pid - the process
+*
+* @return	user and system time in seconds, 0 if it can not be read
+*
+**************************************************************************/
+static double processCpu(pid_t pid) {
+    char path[64], text[1024];
+    unsigned long utime = 0, stime = 0;
+    FILE *file;
+
+    snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+    if ((file = fopen(path, "r")) == NULL) {
+        return 0;
+    }
+    size_t size = fread(text, 1, sizeof(text) - 1, file);
+    fclose(file);
+    text[size] = '\0';
+
+    // Fields after the command name, which may contain spaces: state is the 3rd, utime the 14th
+    const char *pos = strrchr(text, ')');
+    if (pos == NULL || sscanf(pos + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu", &utime, &stime) != 2) {
+        return 0;
+    }
+    return (double)(utime + stime) / sysconf(_SC_CLK_TCK);
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Reads the counters of a client
+*
+* @param	run - run being measured
+* @param	[out] snapshot - the counters
+* @param	pid - the client
+* @param	source - source of the samples
+*
+* @return	None
+*
+* @note		Histograms of the metrics block are copied into the run on every
+*           snapshot, the last one wins.
+*
+**************************************************************************/
+static void takeSnapshot(struct run_t *run, struct snapshot_t *snapshot, pid_t pid, struct source_t *source) {
+    size_t size;
+    struct stats_t *stats = mapStats(pid, &size);
+
+    memset(snapshot, 0, sizeof(*snapshot));
+    snapshot->ns = monotonicNs();
+    snapshot->delivered = atomic_load(&source->delivered);
+    snapshot->cpu_s = processCpu(pid);
+    if (stats == NULL) {
+        return;
+    }
+
+    snapshot->ticks = atomic_load(&stats->ticks);
+    snapshot->overruns = atomic_load(&stats->overruns);
+    for (uint32_t i = 0; i < stats->port_count; ++i) {
+        snapshot->samples += atomic_load(&stats->ports[i].samples);
+    }
+    memcpy(&run->tick_ns, &stats->tick_ns, sizeof(run->tick_ns));
+    memcpy(&run->tick_lag_ns, &stats->tick_lag_ns, sizeof(run->tick_lag_ns));
+    memcpy(&run->ack_ns, &stats->ack_ns, sizeof(run->ack_ns));
+    memcpy(&run->react_ns, &stats->react_ns, sizeof(run->react_ns));
+    run->acks = atomic_load(&stats->acks);
+    run->ack_timeouts = atomic_load(&stats->ack_timeouts);
+    munmap(stats, size);
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Runs a client against the source for the duration of a run
+*
+* @param	[in,out] run - run to measure, client, channels and control are set
+* @param	path - executable of the client
+* @param	channels - number of channels
+* @param	responder - control responder, used if the run measures control
+*
+* @return	0 on success, -1 if the client could not be run
+*
+* @note		The client is started with metrics (-S) and its output is read
+*           through a pipe. Its metrics block is removed after it is killed.
+*
+**************************************************************************/
+static int benchClient(struct run_t *run, const char *path, size_t channels, struct responder_t *responder) {
+    char channel_file[64], rules_file[64], tick[32], udp_port[16], buffer[65536];
+    struct source_t source = {.rate = sample_rate};
+    struct sockaddr_in addr = {.sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK)};
+    socklen_t addr_size = sizeof(addr);
+    int listenfd, pipefd[2];
+    pthread_t thread;
+    FILE *file;
+
+    run->channels = channels;
+    if ((listenfd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0)) < 0 || bind(listenfd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(listenfd, SOMAXCONN) < 0 || getsockname(listenfd, (struct sockaddr *)&addr, &addr_size) < 0) {
+        error_exit("Unable to listen");
+    }
+
+    // Every channel is a connection to the same port
+    snprintf(channel_file, sizeof(channel_file), "/tmp/client_bench.%d.channels", getpid());
+    snprintf(rules_file, sizeof(rules_file), "/tmp/client_bench.%d.rules", getpid());
+    if ((file = fopen(channel_file, "w")) == NULL) {
+        error_exit("Unable to write the channel file");
+    }
+    for (size_t i = 0; i < channels; ++i) {
+        fprintf(file, "127.0.0.1:%u\n", ntohs(addr.sin_port));
+    }
+    fclose(file);
+    if (run->control) {
+        if ((file = fopen(rules_file, "w")) == NULL) {
+            error_exit("Unable to write the rules file");
+        }
+        fputs(CONTROL_RULES, file);
+        fclose(file);
+    }
+
+    snprintf(tick, sizeof(tick), "%lu", tick_ms);
+    snprintf(udp_port, sizeof(udp_port), "%u", responder->port);
+    if (pipe(pipefd) < 0) {
+        error_exit("Pipe failed");
+    }
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        error_exit("Fork failed");
+    }
+    if (pid == 0) {
+        dup2(pipefd[1], STDOUT_FILENO);
+        close(pipefd[0]);
+        close(pipefd[1]);
+        close(listenfd);
+        if (run->control) {
+            execl(path, path, "-S", "-i", tick, "-c", channel_file, "-E", "-A", "-r", rules_file, "-u", udp_port, (char *)NULL);
+        } else {
+            execl(path, path, "-S", "-i", tick, "-c", channel_file, "-u", udp_port, (char *)NULL);
+        }
+        fprintf(stderr, "Unable to run %s: %s\n", path, strerror(errno));
+        _exit(EXIT_FAILURE);
+    }
+    close(pipefd[1]);
+
+    source.connections = calloc(channels, sizeof(*source.connections));
+    if (source.connections == NULL) {
+        error_exit("Calloc failed");
+    }
+
+    uint64_t deadline_ns = monotonicNs() + CONNECT_TIMEOUT_MS * 1000000ull;
+    while (source.count < channels && monotonicNs() < deadline_ns) {
+        struct pollfd pfd = {.fd = listenfd, .events = POLLIN};
+        int sockfd;
+
+        poll(&pfd, 1, 100);
+        while (source.count < channels && (sockfd = accept4(listenfd, NULL, NULL, SOCK_NONBLOCK)) >= 0) {
+            source.connections[source.count++].sockfd = sockfd;
+        }
+    }
+
+    if (source.count < channels) {
+        run->failed = 1;
+    } else {
+        source.start_ns = monotonicNs();
+        if (pthread_create(&thread, NULL, runSource, &source) != 0) {
+            error_exit("Unable to start the source");
+        }
+
+        // Output is read as it comes, the latency is measured after the warmup
+        uint64_t start_ns = source.start_ns + WARMUP_MS * 1000000ull;
+        uint64_t end_ns = start_ns + duration_ms * 1000000ull;
+        size_t used = 0;
+        int measuring = 0;
+
+        while (1) {
+            uint64_t now_ns = monotonicNs();
+            if (!measuring && now_ns >= start_ns) {
+                takeSnapshot(run, &run->first, pid, &source);
+                measuring = 1;
+            }
+            if (now_ns >= end_ns) {
+                break;
+            }
+
+            struct pollfd pfd = {.fd = pipefd[0], .events = POLLIN};
+            if (poll(&pfd, 1, 10) <= 0) {
+                continue;
+            }
+            ssize_t size = read(pipefd[0], &buffer[used], sizeof(buffer) - used - 1);
+            if (size <= 0) {
+                run->failed = 1;
+                break;
+            }
+            now_ns = monotonicNs();
+            used += size;
+            buffer[used] = '\0';
+
+            char *line = buffer, *end;
+            while ((end = strchr(line, '\n')) != NULL) {
+                *end = '\0';
+                if (measuring) {
+                    consumeOutput(run, line, now_ns);
+                }
+                line = end + 1;
+            }
+            used = &buffer[used] - line;
+            memmove(buffer, line, used);
+            if (used == sizeof(buffer) - 1) {
+                used = 0;
+            }
+        }
+        takeSnapshot(run, &run->last, pid, &source);
+        qsort(run->latency_ns, run->latency_count, sizeof(*run->latency_ns), compareLatency);
+
+        atomic_store(&source.stop, 1);
+        pthread_join(thread, NULL);
+    }
+
+    kill(pid, SIGKILL);
+    waitpid(pid, NULL, 0);
+
+    char name[64];
+    snprintf(name, sizeof(name), STATS_SHM_PREFIX "%d", pid);
+    shm_unlink(name);
+    unlink(channel_file);
+    unlink(rules_file);
+
+    for (size_t i = 0; i < source.count; ++i) {
+        if (source.connections[i].sockfd >= 0) {
+            close(source.connections[i].sockfd);
+        }
+    }
+    free(source.connections);
+    close(pipefd[0]);
+    close(listenfd);
+
+    return run->failed ? -1 : 0;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Checks if the client kept up with a run
+*
+* @param	run - the measured run
+*
+* @return	1 if almost no tick was missed and the client read almost all sent samples
+*
+* @note		A single missed tick is tolerated, on a loaded machine the scheduler
+*           alone causes some.
+*
+**************************************************************************/
+static int passed(const struct run_t *run) {
+    uint64_t ticks = run->last.ticks - run->first.ticks;
+    uint64_t overruns = run->last.overruns - run->first.overruns;
+    uint64_t delivered = run->last.delivered - run->first.delivered;
+    uint64_t samples = run->last.samples - run->first.samples;
+
+    return !run->failed && ticks > 0 && overruns <= 1 + PASS_OVERRUNS * ticks && samples >= PASS_DELIVERY * delivered;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Orders latencies for qsort
+*
+**************************************************************************/
+static int compareLatency(const void *a, const void *b) {
+    uint64_t left = *(const uint64_t *)a, right = *(const uint64_t *)b;
+
+    return (left > right) - (left < right);
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Gets a percentile of the latencies of a run
+*
+* @param	run - the measured run, latencies sorted
+* @param	percentile - 0 ... 100
+*
+* @return	latency in microseconds, 0 if nothing was measured
+*
+**************************************************************************/
+static double latencyPercentile(const struct run_t *run, double percentile) {
+    if (run->latency_count == 0) {
+        return 0;
+    }
+
+    size_t rank = (size_t)(percentile / 100.0 * (run->latency_count - 1) + 0.5);
+    return run->latency_ns[rank] / 1e3;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Writes the results of a run as a JSON object
+*
+* @param	out - output file
+* @param	run - the measured run
+*
+* @return	None
+*
+**************************************************************************/
+static void writeRun(FILE *out, const struct run_t *run) {
+    double seconds = (run->last.ns - run->first.ns) / 1e9;
+    uint64_t ticks = run->last.ticks - run->first.ticks;
+    uint64_t samples = run->last.samples - run->first.samples;
+    uint64_t delivered = run->last.delivered - run->first.delivered;
+
+    fprintf(out, "{\"client\": \"%s\", \"channels\": %zu, \"control\": %s, \"pass\": %s, ",
+            run->client, run->channels, run->control ? "true" : "false", passed(run) ? "true" : "false");
+    if (run->failed) {
+        fprintf(out, "\"failed\": true}");
+        return;
+    }
+
+    fprintf(out, "\"sent_per_sec\": %.0f, \"samples_per_sec\": %.0f, \"delivery\": %.4f, "
+                 "\"ticks\": %" PRIu64 ", \"overruns\": %" PRIu64 ", \"cpu_per_tick_us\": %.1f, "
+                 "\"tick_us\": {\"p50\": %.1f, \"p99\": %.1f, \"max\": %.1f}, "
+                 "\"tick_lag_us\": {\"p50\": %.1f, \"p99\": %.1f, \"max\": %.1f}, "
+                 "\"latency_us\": {\"count\": %zu, \"p50\": %.1f, \"p99\": %.1f, \"max\": %.1f}",
+            delivered / seconds, samples / seconds, delivered ? (double)samples / delivered : 0.0,
+            ticks, run->last.overruns - run->first.overruns, ticks ? (run->last.cpu_s - run->first.cpu_s) * 1e6 / ticks : 0.0,
+            statsPercentile(&run->tick_ns, 50) / 1e3, statsPercentile(&run->tick_ns, 99) / 1e3, run->tick_ns.max / 1e3,
+            statsPercentile(&run->tick_lag_ns, 50) / 1e3, statsPercentile(&run->tick_lag_ns, 99) / 1e3, run->tick_lag_ns.max / 1e3,
+            run->latency_count, latencyPercentile(run, 50), latencyPercentile(run, 99), latencyPercentile(run, 100));
+    if (run->control) {
+        fprintf(out, ", \"acks\": %" PRIu64 ", \"ack_timeouts\": %" PRIu64 ", "
+                     "\"ack_us\": {\"p50\": %.1f, \"p99\": %.1f, \"max\": %.1f}, "
+                     "\"react_us\": {\"p50\": %.1f, \"p99\": %.1f, \"max\": %.1f}",
+                run->acks, run->ack_timeouts,
+                statsPercentile(&run->ack_ns, 50) / 1e3, statsPercentile(&run->ack_ns, 99) / 1e3, run->ack_ns.max / 1e3,
+                statsPercentile(&run->react_ns, 50) / 1e3, statsPercentile(&run->react_ns, 99) / 1e3, run->react_ns.max / 1e3);
+    }
+    fputc('}', out);
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Main function for the end-to-end benchmark.
+*
+* @param	None
+*
+* @return	0 on success
+*
+* @note		For every client the channel count is doubled until a run does not
+*           pass, then client2 is run with the control rules on the reader path
+*           and read-back acks to measure the control round trip.
+*
+**************************************************************************/
+int main(int argc, char *argv[]) {
+    static struct responder_t responder;
+    static struct run_t runs[2 * CHANNEL_STEPS_MAX + 1];
+    const char *clients[2][2] = {{"client1", "task1/client1"}, {"client2", "task2/client2"}};
+    const char *out_path = NULL;
+    unsigned long max_channels = 256;
+    size_t run_count = 0, best[2] = {0, 0};
+    pthread_t thread;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "c:d:i:o:r:h")) != -1) {
+        switch (opt) {
+        case 'c':
+            max_channels = strtoul(optarg, NULL, 10);
+            break;
+        case 'd':
+            duration_ms = strtoul(optarg, NULL, 10);
+            break;
+        case 'i':
+            tick_ms = strtoul(optarg, NULL, 10);
+            break;
+        case 'o':
+            out_path = optarg;
+            break;
+        case 'r':
+            sample_rate = strtoul(optarg, NULL, 10);
+            break;
+        default:
+            optind = argc + 1;
+            break;
+        }
+    }
+
+    // Values must not wrap while a sample may still be in the output
+    if (optind != argc || max_channels == 0 || duration_ms == 0 || tick_ms == 0 || sample_rate == 0 ||
+        sample_rate * (tick_ms + 1000) / 1000 >= SEQ_PERIOD / 2) {
+        fprintf(stderr, "Usage: %s [-c max_channels] [-d duration_ms] [-i tick_ms] [-r samples_per_sec] [-o result_file]\n"
+                        "  -c  largest channel count to try, 256 by default\n"
+                        "  -d  measured time of every run, 2000ms by default\n"
+                        "  -i  tick period of the clients, 10ms by default\n"
+                        "  -r  samples per second of every channel, 1000 by default\n"
+                        "  -o  file for the JSON results, stdout by default\n"
+                        "Run from the repository root, the clients are task1/client1 and task2/client2.\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    struct sockaddr_in addr = {.sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK)};
+    struct timeval timeout = {0, 100000};
+    socklen_t addr_size = sizeof(addr);
+    if ((responder.sockfd = socket(AF_INET, SOCK_DGRAM, 0)) < 0 || bind(responder.sockfd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        getsockname(responder.sockfd, (struct sockaddr *)&addr, &addr_size) < 0 ||
+        setsockopt(responder.sockfd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) < 0) {
+        error_exit("Unable to open the control socket");
+    }
+    responder.port = ntohs(addr.sin_port);
+    if (pthread_create(&thread, NULL, runResponder, &responder) != 0) {
+        error_exit("Unable to start the control responder");
+    }
+
+    for (int c = 0; c < 2; ++c) {
+        for (size_t channels = 1; channels <= max_channels && run_count < 2 * CHANNEL_STEPS_MAX; channels *= 2) {
+            struct run_t *run = &runs[run_count++];
+
+            run->client = clients[c][0];
+            benchClient(run, clients[c][1], channels, &responder);
+            fprintf(stderr, "%s: %zu channels, %s\n", run->client, channels, passed(run) ? "pass" : "fail");
+            if (!passed(run)) {
+                break;
+            }
+            best[c] = run_count;
+        }
+    }
+
+    struct run_t *control = &runs[run_count++];
+    control->client = clients[1][0];
+    control->control = 1;
+    benchClient(control, clients[1][1], CONTROL_CHANNELS, &responder);
+    fprintf(stderr, "%s: control round trip, %s\n", control->client, control->failed ? "fail" : "done");
+
+    atomic_store(&responder.stop, 1);
+    pthread_join(thread, NULL);
+    close(responder.sockfd);
+
+    FILE *out = stdout;
+    if (out_path != NULL && (out = fopen(out_path, "w")) == NULL) {
+        error_exit("Unable to open the result file");
+    }
+
+    fprintf(out, "{\"sample_rate\": %lu, \"tick_ms\": %lu, \"duration_ms\": %lu, \"cpus\": %ld,\n \"runs\": [\n",
+            sample_rate, tick_ms, duration_ms, sysconf(_SC_NPROCESSORS_ONLN));
+    for (size_t i = 0; i < run_count; ++i) {
+        fputs("  ", out);
+        writeRun(out, &runs[i]);
+        fputs((i + 1 < run_count) ? ",\n" : "\n", out);
+        free(runs[i].latency_ns);
+    }
+    fputs(" ],\n \"summary\": [\n", out);
+    for (int c = 0; c < 2; ++c) {
+        size_t channels = best[c] ? runs[best[c] - 1].channels : 0;
+        fprintf(out, "  {\"client\": \"%s\", \"max_channels\": %zu, \"max_samples_per_sec\": %lu}%s\n",
+                clients[c][0], channels, channels * sample_rate, c ? "" : ",");
+    }
+    fputs(" ]}\n", out);
+
+    if (out != stdout) {
+        fclose(out);
+        fprintf(stderr, "Results written to %s\n", out_path);
+    }
+    return 0;
+}
@@ -0,0 +1,155 @@
+/*****************************************************************************/
+/**
+*  Brief: 	Converts logs between the JSON lines form and the binary columnar form,
+*           and compresses binary logs.
+*           The direction is taken from the input file, the log can be cut to a
+*           time range while converting.
+*
+*  Created: 16.10.2026
+*  Author: 	Yurii Shenbor
+*
+******************************************************************************/
+
+/***************************** Include Files ********************************/
+
+#include "../lib/client_lib.h"
+#include "../lib/output.h"
+#include "../lib/bin_log.h"
+#include "../lib/log_reader.h"
+#include <getopt.h>
+
+/************************** Constant Definitions *****************************/
+
+#define CONVERT_FLUSH_LINES     256     // JSON lines buffered before a write
+
+/**************************************************************************/
+/**
+*
+* @brief    Converts rows of a log within a time range into the other format
+*
+* @param	input - path to the JSON or binary log
+* @param	output - path to the converted log
+* @param	from_ms - first timestamp to convert
+* @param	to_ms - last timestamp to convert
+* @param	flags - BIN_LOG_* flags added to a binary output (i.e. BIN_LOG_COMPRESSED)
+*
+* @return	0 on success, otherwise -1
+*
+* @note		Blocks of a binary log before the range are skipped using the block index.
+*           A binary log is converted to JSON lines, unless a compressed output is
+*           requested. JSON lines are written to standard output if the output is "-".
+*
+**************************************************************************/
+static int convertLog(const char *input, const char *output, int64_t from_ms, int64_t to_ms, uint16_t flags) {
+    struct log_reader_t reader;
+    struct bin_log_block_t block;
+    struct bin_log_t log;
+    struct output_t out;
+    size_t rows = 0;
+    int fd = -1;
+
+    if (openLogReader(&reader, input, from_ms, to_ms) < 0) {
+        fprintf(stderr, "No log lines found in %s\n", input);
+        return -1;
+    }
+
+    uint32_t channels = reader.channels;
+    int keys_data = (reader.flags & BIN_LOG_KEYS_DATA) && channels == 1;
+    int to_json = reader.binary && !(flags & BIN_LOG_COMPRESSED);
+    struct sample_t *values = calloc(channels, sizeof(*values));
+    int status = (values == NULL) ? -1 : 0;
+
+    if (status == 0 && to_json) {
+        fd = (strcmp(output, "-") == 0) ? dup(STDOUT_FILENO) : open(output, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0 ||
+            initOutput(&out, fd, channels, CONVERT_FLUSH_LINES, 0) < 0) {
+            status = -1;
+        }
+    } else if (status == 0) {
+        status = openBinLog(&log, output, channels, 0, (reader.flags & BIN_LOG_KEYS_DATA) | flags);
+    }
+    if (status < 0) {
+        perror("Unable to create output");
+        closeLogReader(&reader);
+        free(values);
+        return -1;
+    }
+
+    while (readLogBlock(&reader, &block) > 0) {
+        for (uint32_t row = 0; row < block.rows; ++row) {
+            for (uint32_t ch = 0; ch < channels; ++ch) {
+                int32_t value = block.values[ch * block.stride + row];
+                values[ch].value = value;
+                values[ch].valid = (value != BIN_LOG_INVALID);
+            }
+
+            if (!to_json) {
+                if (appendBinLog(&log, block.timestamps[row], values) < 0) {
+                    error_exit("Output write failed");
+                }
+            } else if (keys_data) {
+                writeLogRecord(&out, block.timestamps[row], values[0]);
+            } else {
+                writeTick(&out, block.timestamps[row], values);
+            }
+        }
+        rows += block.rows;
+    }
+
+    if (to_json) {
+        closeOutput(&out);
+        close(fd);
+    } else if (closeBinLog(&log) < 0) {
+        perror("Output write failed");
+        status = -1;
+    }
+
+    closeLogReader(&reader);
+    free(values);
+
+    fprintf(stderr, "%zu rows, %u channel(s) converted\n", rows, channels);
+    return status;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Main function for log converter.
+*
+* @param	None
+*
+* @return	None
+*
+* @note		None
+*
+**************************************************************************/
+int main(int argc, char *argv[]) {
+    int64_t from_ms = INT64_MIN, to_ms = INT64_MAX;
+    uint16_t flags = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:e:zh")) != -1) {
+        switch (opt) {
+        case 's':
+            from_ms = strtoll(optarg, NULL, 10);
+            break;
+        case 'e':
+            to_ms = strtoll(optarg, NULL, 10);
+            break;
+        case 'z':
+            flags |= BIN_LOG_COMPRESSED;
+            break;
+        default:
+            optind = argc;
+            break;
+        }
+    }
+
+    if (argc - optind != 2) {
+        fprintf(stderr, "Usage: %s [-s from_ms] [-e to_ms] [-z] <Input> <Output | ->\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    int status = convertLog(argv[optind], argv[optind + 1], from_ms, to_ms, flags);
+    return (status == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
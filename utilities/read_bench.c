@@ -0,0 +1,215 @@
+/*****************************************************************************/
+/**
+*  Brief: 	Measures throughput of the client_lib read path over loopback TCP
+*           connections, for every receive backend that is built in.
+*
+*  Created: 16.10.2026
+*  Author: 	Yurii Shenbor
+*
+******************************************************************************/
+
+/***************************** Include Files ********************************/
+
+#define _GNU_SOURCE     // RUSAGE_THREAD
+
+#include "../lib/client_lib.h"
+#include <sys/resource.h>
+
+/************************** Constant Definitions *****************************/
+
+#define CHUNK_LINES     64      // Lines written to a connection at once
+
+/**************************** Type Definitions *******************************/
+
+struct writer_t {
+    int *sockfd;
+    int count;
+    atomic_int stop;
+};
+
+/**************************************************************************/
+/**
+*
+* @brief    Writes lines to all connections as fast as the reader takes them
+*
+* @param	args - writer state
+*
+* @return	None
+*
+* @note		A partially written chunk is continued on the next pass, so lines stay intact.
+*
+**************************************************************************/
+static void* writeLines(void *args) {
+    struct writer_t *writer = (struct writer_t *)args;
+    char chunk[CHUNK_LINES * 8];
+    size_t chunk_size = 0;
+    size_t *offset = calloc(writer->count, sizeof(size_t));
+
+    if (offset == NULL) {
+        error_exit("Calloc failed");
+    }
+
+    for (int i = 0; i < CHUNK_LINES; ++i) {
+        chunk_size += sprintf(&chunk[chunk_size], (i & 1) ? "-3.1\n" : "12.7\n");
+    }
+
+    while (!atomic_load(&writer->stop)) {
+        for (int i = 0; i < writer->count; ++i) {
+            ssize_t sent = send(writer->sockfd[i], &chunk[offset[i]], chunk_size - offset[i], MSG_DONTWAIT | MSG_NOSIGNAL);
+            if (sent > 0) {
+                offset[i] = (offset[i] + sent) % chunk_size;
+            }
+        }
+    }
+
+    free(offset);
+    return NULL;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Counts received samples
+*
+* @param	port - port the sample was received from
+* @param	sample - the received value
+* @param	ctx - counter
+*
+* @return	None
+*
+**************************************************************************/
+static void countSample(struct port_t *port, struct sample_t sample, void *ctx) {
+    (*(uint64_t *)ctx)++;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Returns CPU time used by the calling thread in seconds
+*
+**************************************************************************/
+static double threadCpuTime(void) {
+    struct rusage usage;
+
+    getrusage(RUSAGE_THREAD, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Runs the read path with the given backend for the given time
+*
+* @param	backend - receive backend
+* @param	channels - number of connections
+* @param	duration_sec - duration of the run
+*
+* @return	None
+*
+* @note		Prints a single JSON line with the results.
+*
+**************************************************************************/
+static void runBenchmark(enum backend_e backend, int channels, int duration_sec) {
+    struct sockaddr_in addr = {.sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK)};
+    socklen_t addr_size = sizeof(addr);
+    struct port_t *ports = calloc(channels, sizeof(*ports));
+    struct writer_t writer = {.sockfd = calloc(channels, sizeof(int)), .count = channels};
+    struct event_loop_t loop;
+    struct timespec start, now;
+    uint64_t samples = 0;
+    pthread_t thread;
+
+    if (ports == NULL || writer.sockfd == NULL) {
+        error_exit("Calloc failed");
+    }
+
+    int listenfd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listenfd < 0 || bind(listenfd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(listenfd, channels) < 0) {
+        error_exit("Unable to listen");
+    }
+    getsockname(listenfd, (struct sockaddr *)&addr, &addr_size);
+
+    for (int i = 0; i < channels; ++i) {
+        if ((ports[i].sockfd = connectToPort(&addr, 0)) < 0) {
+            error_exit("Unable to connect");
+        }
+        ports[i].on_sample = countSample;
+        ports[i].ctx = &samples;
+        if ((writer.sockfd[i] = accept(listenfd, NULL, NULL)) < 0) {
+            error_exit("Accept failed");
+        }
+    }
+
+    event_backend = backend;
+    if (initEventLoop(&loop, ports, channels, 0) < 0) {
+        error_exit("Unable to start event loop");
+    }
+    if (backend == BACKEND_IO_URING && loop.uring == NULL) {
+        fprintf(stderr, "io_uring backend is not available (build with URING=1)\n");
+    }
+    const char *name = (loop.uring != NULL) ? "io_uring" : "epoll";
+
+    pthread_create(&thread, NULL, writeLines, &writer);
+
+    double cpu = threadCpuTime();
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    do {
+        dispatchEvents(&loop, 100);
+        clock_gettime(CLOCK_MONOTONIC, &now);
+    } while (now.tv_sec - start.tv_sec < duration_sec);
+    cpu = threadCpuTime() - cpu;
+
+    atomic_store(&writer.stop, 1);
+    pthread_join(thread, NULL);
+
+    double elapsed = (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1e9;
+    printf("{\"backend\": \"%s\", \"channels\": %d, \"samples\": %lu, \"samples_per_sec\": %.0f, "
+           "\"reader_cpu_sec\": %.3f, \"ns_per_sample\": %.1f}\n",
+           name, channels, samples, samples / elapsed, cpu, cpu * 1e9 / (samples ? samples : 1));
+
+    closeEventLoop(&loop);
+    for (int i = 0; i < channels; ++i) {
+        close(ports[i].sockfd);
+        close(writer.sockfd[i]);
+    }
+    close(listenfd);
+    free(writer.sockfd);
+    free(ports);
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Main function for read benchmark.
+*
+* @param	None
+*
+* @return	None
+*
+* @note		Without a backend argument all built in backends are measured.
+*
+**************************************************************************/
+int main(int argc, char *argv[]) {
+    if (argc < 3 || argc > 4) {
+        fprintf(stderr, "Usage: %s <Channels> <Duration_sec> [epoll|io_uring]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    int channels = atoi(argv[1]);
+    int duration_sec = atoi(argv[2]);
+
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    if (argc == 4) {
+        runBenchmark(strcmp(argv[3], "io_uring") == 0 ? BACKEND_IO_URING : BACKEND_EPOLL, channels, duration_sec);
+    } else {
+        runBenchmark(BACKEND_EPOLL, channels, duration_sec);
+        runBenchmark(BACKEND_IO_URING, channels, duration_sec);
+    }
+
+    return 0;
+}
@@ -0,0 +1,195 @@
+/*****************************************************************************/
+/**
+*  Brief: 	Consumes the shared memory rings of a running client. Prints every
+*           record as a JSON line, or only measures the rate and the latency.
+*
+*  Created: 16.10.2026
+*  Author: 	Yurii Shenbor
+*
+******************************************************************************/
+
+/***************************** Include Files ********************************/
+
+#include "../lib/client_lib.h"
+#include "../lib/shm_ring.h"
+#include "../lib/histogram.h"
+#include <getopt.h>
+
+/************************** Constant Definitions *****************************/
+
+#define MAX_RECORD_WORDS    65536
+#define IDLE_SLEEP_US       50      // Sleep when all rings are empty, unless spinning
+
+/**************************************************************************/
+/**
+*
+* @brief    Prints a record as a JSON line
+*
+* @param	ring - ring the record was read from
+* @param	record - the record
+*
+* @return	None
+*
+**************************************************************************/
+static void printRecord(const struct shm_ring_t *ring, const uint64_t *record) {
+    char text[SAMPLE_TEXT_SIZE];
+
+    if (ring->kind == RING_SAMPLES) {
+        int32_t value = (int32_t)(record[1] >> 32);
+        formatSample((struct sample_t){value, 1}, text);
+        printf("{\"timestamp_ns\": %lu, \"channel\": %u, \"value\": \"%s\"}\n", record[0], (uint32_t)record[1], text);
+        return;
+    }
+
+    printf("{\"timestamp\": %lu", record[0]);
+    for (uint32_t ch = 0; ch < ring->channels; ++ch) {
+        int32_t value = (int32_t)(record[1 + ch / 2] >> (32 * (ch & 1)));
+        formatSample((struct sample_t){value, value != RING_INVALID}, text);
+        printf(", \"out%u\": \"%s\"", ch + 1, text);
+    }
+    printf("}\n");
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Main function for ring reader.
+*
+* @param	None
+*
+* @return	None
+*
+* @note		With -m the latency of raw samples is the time from their publication
+*           by the client to their reading, both taken from CLOCK_REALTIME.
+*
+**************************************************************************/
+int main(int argc, char *argv[]) {
+    int samples = 0, measure = 0, from_oldest = 0, spin = 0;
+    unsigned long duration_sec = 0;
+    static struct histogram_t latency;
+    struct ring_consumer_t *consumers;
+    uint32_t consumer_count = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "d:mopsh")) != -1) {
+        switch (opt) {
+        case 'd':
+            duration_sec = strtoul(optarg, NULL, 10);
+            break;
+        case 'm':
+            measure = 1;
+            break;
+        case 'o':
+            from_oldest = 1;
+            break;
+        case 'p':
+            spin = 1;
+            break;
+        case 's':
+            samples = 1;
+            break;
+        default:
+            optind = argc;
+            break;
+        }
+    }
+
+    if (argc - optind != 1) {
+        fprintf(stderr, "Usage: %s [-s] [-o] [-m] [-p] [-d duration_sec] <Pid>\n"
+                        "  -s  read raw samples instead of ticks\n"
+                        "  -o  start from the oldest record kept\n"
+                        "  -m  only measure rate, latency and lost records\n"
+                        "  -p  poll without sleeping, for the lowest latency\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    int pid = atoi(argv[optind]);
+    struct ring_consumer_t first;
+    if (openRingConsumer(&first, pid, 0, from_oldest) < 0) {
+        error_exit("Unable to map rings");
+    }
+
+    // Ticks are in ring 0, raw samples in every other ring
+    uint32_t ring_count = first.segment->ring_count;
+    consumers = calloc(ring_count, sizeof(*consumers));
+    uint64_t *record = malloc(MAX_RECORD_WORDS * sizeof(uint64_t));
+    if (consumers == NULL || record == NULL) {
+        error_exit("Calloc failed");
+    }
+
+    if (!samples) {
+        consumers[consumer_count++] = first;
+    } else {
+        closeRingConsumer(&first);
+        for (uint32_t i = 1; i < ring_count; ++i) {
+            if (openRingConsumer(&consumers[consumer_count], pid, i, from_oldest) == 0) {
+                consumer_count++;
+            }
+        }
+        if (consumer_count == 0) {
+            error_exit("Raw samples are not published (client option -R all)");
+        }
+    }
+    if (consumers[0].ring->record_words > MAX_RECORD_WORDS) {
+        error_exit("Record is too large");
+    }
+
+    initHistogram(&latency);
+    struct timespec start, now;
+    uint64_t records = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    while (1) {
+        int idle = 1;
+
+        for (uint32_t i = 0; i < consumer_count; ++i) {
+            while (readRing(&consumers[i], record)) {
+                idle = 0;
+                records++;
+                if (!measure) {
+                    printRecord(consumers[i].ring, record);
+                } else if (samples) {
+                    struct timespec real;
+                    clock_gettime(CLOCK_REALTIME, &real);
+                    uint64_t now_ns = (uint64_t)real.tv_sec * 1000000000ull + real.tv_nsec;
+                    recordValue(&latency, (now_ns > record[0]) ? now_ns - record[0] : 0);
+                }
+            }
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (duration_sec > 0 && (unsigned long)(now.tv_sec - start.tv_sec) >= duration_sec) {
+            break;
+        }
+        if (idle && !spin) {
+            if (!measure) {
+                fflush(stdout);
+            }
+            usleep(IDLE_SLEEP_US);
+        }
+    }
+
+    uint64_t lost = 0;
+    for (uint32_t i = 0; i < consumer_count; ++i) {
+        lost += consumers[i].lost;
+        closeRingConsumer(&consumers[i]);
+    }
+
+    if (measure) {
+        double elapsed = (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1e9;
+        printf("{\"rings\": %u, \"records\": %lu, \"records_per_sec\": %.0f, \"lost\": %lu", consumer_count, records,
+               records / elapsed, lost);
+        if (samples) {
+            printf(", \"latency_ns\": {\"p50\": %lu, \"p99\": %lu, \"p99.9\": %lu, \"max\": %lu}",
+                   valueAtPercentile(&latency, 50), valueAtPercentile(&latency, 99),
+                   valueAtPercentile(&latency, 99.9), latency.max);
+        }
+        printf("}\n");
+    } else {
+        fprintf(stderr, "%lu records lost\n", lost);
+    }
+
+    free(record);
+    free(consumers);
+    return 0;
+}
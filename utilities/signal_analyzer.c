@@ -0,0 +1,309 @@
+/*****************************************************************************/
+/**
+*  Brief: 	Measures amplitude, frequency and shape of every channel of a log in
+*           a single streaming pass. Reads JSON lines logs and binary logs.
+*
+*  Created: 16.10.2026
+*  Author: 	Yurii Shenbor
+*
+******************************************************************************/
+
+/***************************** Include Files ********************************/
+
+#include "../lib/client_lib.h"
+#include "../lib/log_reader.h"
+#include <getopt.h>
+
+/************************** Constant Definitions *****************************/
+
+#define AMPLITUDE_TOLERANCE     10      // Percent the amplitude of a period may differ from the ones before
+#define PERIOD_TOLERANCE        25      // Same for the period, it is only as exact as the sample spacing
+
+/**************************** Type Definitions *******************************/
+
+struct channel_stats_t {
+    uint64_t samples;
+    uint64_t missing;                   // "--" values
+    int32_t min;
+    int32_t max;
+    int64_t sum;
+    int64_t sum_squares;
+    int state;                          // side of the midline the signal is on, 0 before the first sample
+    uint64_t rises;                     // crossings of the midline upwards
+    int64_t first_rise_ms;
+    int64_t last_rise_ms;
+    struct signal_estimator_t estimator;    // classifies every period on its own
+    uint64_t shapes[SIGNAL_TRIANGLE + 1];   // periods of every shape
+    uint64_t changes;                   // periods whose amplitude or period differs from the ones before
+    uint64_t run_periods;               // periods since the last change
+    uint64_t run_period_ns;             // sum of their periods
+    int64_t run_amplitude;              // sum of their amplitudes
+};
+
+/**************************************************************************/
+/**
+*
+* @brief    Accumulates value statistics of a column
+*
+* @param	stats - channel statistics
+* @param	values - value column
+* @param	rows - number of rows
+*
+* @return	None
+*
+* @note		The loop has no branches, so the compiler can vectorize it.
+*
+**************************************************************************/
+static void accumulateValues(struct channel_stats_t *stats, const int32_t *values, uint32_t rows) {
+    int32_t min = stats->min, max = stats->max;
+    int64_t sum = 0, sum_squares = 0;
+    uint32_t valid_count = 0;
+
+    for (uint32_t i = 0; i < rows; ++i) {
+        int32_t value = values[i];
+        int32_t valid = (value != BIN_LOG_INVALID);
+        int32_t masked = value & -valid;
+
+        min = (valid && value < min) ? value : min;
+        max = (valid && value > max) ? value : max;
+        sum += masked;
+        sum_squares += (int64_t)masked * masked;
+        valid_count += valid;
+    }
+
+    stats->min = min;
+    stats->max = max;
+    stats->sum += sum;
+    stats->sum_squares += sum_squares;
+    stats->samples += valid_count;
+    stats->missing += rows - valid_count;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Counts upward crossings of the midline in a column
+*
+* @param	stats - channel statistics
+* @param	timestamps - timestamp column
+* @param	values - value column
+* @param	rows - number of rows
+* @param	hysteresis - values closer to the midline than this don't change the side
+*
+* @return	None
+*
+* @note		The midline is taken from the range seen so far, so signals that are
+*           not centered at zero (i.e. a 0 ... 5 V square) are handled too.
+*
+**************************************************************************/
+static void countCrossings(struct channel_stats_t *stats, const int64_t *timestamps, const int32_t *values, uint32_t rows, int32_t hysteresis) {
+    int state = stats->state;
+
+    // No valid sample yet, the range is still empty
+    if (stats->min > stats->max) {
+        return;
+    }
+
+    int32_t mid = stats->min + (stats->max - stats->min) / 2;
+    int32_t span = (stats->max - stats->min) / ESTIMATOR_HYSTERESIS_DIVIDER;
+
+    if (span > hysteresis) {
+        hysteresis = span;
+    }
+
+    for (uint32_t i = 0; i < rows; ++i) {
+        int32_t value = values[i];
+        if (value == BIN_LOG_INVALID) {
+            continue;
+        }
+
+        if (value > mid + hysteresis) {
+            if (state < 0) {
+                if (stats->rises++ == 0) {
+                    stats->first_rise_ms = timestamps[i];
+                }
+                stats->last_rise_ms = timestamps[i];
+            }
+            state = 1;
+        } else if (value < mid - hysteresis) {
+            state = -1;
+        }
+    }
+
+    stats->state = state;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Measures every period of a column on its own
+*
+* @param	stats - channel statistics
+* @param	timestamps - timestamp column
+* @param	values - value column
+* @param	rows - number of rows
+*
+* @return	None
+*
+* @note		The same estimator as in the clients is used, so a signal whose
+*           amplitude or frequency changes during the capture is classified by
+*           its periods instead of the blend of all of them.
+*
+**************************************************************************/
+static void measurePeriods(struct channel_stats_t *stats, const int64_t *timestamps, const int32_t *values, uint32_t rows) {
+    struct signal_estimator_t *e = &stats->estimator;
+
+    for (uint32_t i = 0; i < rows; ++i) {
+        if (values[i] == BIN_LOG_INVALID ||
+            !estimateSignal(e, values[i], (uint64_t)timestamps[i] * 1000000) || e->period_ns == 0) {
+            continue;
+        }
+        if (e->shape <= SIGNAL_TRIANGLE) {
+            stats->shapes[e->shape]++;
+        }
+
+        // Compare with the mean of the periods since the last change
+        if (stats->run_periods > 0) {
+            uint64_t period_ns = stats->run_period_ns / stats->run_periods;
+            int64_t amplitude = stats->run_amplitude / (int64_t)stats->run_periods;
+            uint64_t period_diff = (e->period_ns > period_ns) ? e->period_ns - period_ns : period_ns - e->period_ns;
+            int64_t amplitude_diff = llabs(e->amplitude - amplitude);
+
+            if (period_diff * 100 > period_ns * PERIOD_TOLERANCE ||
+                amplitude_diff * 100 > llabs(amplitude) * AMPLITUDE_TOLERANCE) {
+                stats->changes++;
+                stats->run_periods = 0;
+                stats->run_period_ns = 0;
+                stats->run_amplitude = 0;
+            }
+        }
+        stats->run_periods++;
+        stats->run_period_ns += e->period_ns;
+        stats->run_amplitude += e->amplitude;
+    }
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Prints the results of a channel as a JSON line
+*
+* @param	name - name of the channel
+* @param	stats - channel statistics
+*
+* @return	None
+*
+* @note		The shape is the one most periods have, or taken from the whole
+*           capture if no period was measured. A channel is not stationary if
+*           the amplitude or the period of some period changed.
+*
+**************************************************************************/
+static void printStats(const char *name, const struct channel_stats_t *stats) {
+    if (stats->samples == 0) {
+        printf("{\"channel\": \"%s\", \"samples\": 0, \"missing\": %lu}\n", name, stats->missing);
+        return;
+    }
+
+    int32_t amplitude = (stats->max > -stats->min) ? stats->max : -stats->min;
+    double frequency = 0;
+    if (stats->rises > 1 && stats->last_rise_ms > stats->first_rise_ms) {
+        frequency = (stats->rises - 1) * 1000.0 / (stats->last_rise_ms - stats->first_rise_ms);
+    }
+
+    enum signal_shape_e shape = SIGNAL_UNKNOWN;
+    for (int i = SIGNAL_UNKNOWN; i <= SIGNAL_TRIANGLE; ++i) {
+        if (stats->shapes[i] > stats->shapes[shape]) {
+            shape = i;
+        }
+    }
+    if (stats->shapes[shape] == 0) {
+        shape = classifyShape(stats->samples, stats->sum, stats->sum_squares, stats->min, stats->max);
+    }
+
+    printf("{\"channel\": \"%s\", \"samples\": %lu, \"missing\": %lu, \"min\": %.1f, \"max\": %.1f, "
+           "\"mean\": %.2f, \"amplitude\": %.1f, \"frequency_hz\": %.3f, \"periods\": %lu, \"shape\": \"%s\", "
+           "\"changes\": %lu, \"stationary\": %s}\n",
+           name, stats->samples, stats->missing, stats->min / 10.0, stats->max / 10.0,
+           (double)stats->sum / stats->samples / 10.0, amplitude / 10.0, frequency,
+           stats->rises ? stats->rises - 1 : 0, shapeName(shape),
+           stats->changes, stats->changes ? "false" : "true");
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Main function for signal analyzer.
+*
+* @param	None
+*
+* @return	None
+*
+* @note		Memory use does not depend on the size of the log.
+*
+**************************************************************************/
+int main(int argc, char *argv[]) {
+    int64_t from_ms = INT64_MIN, to_ms = INT64_MAX;
+    int32_t hysteresis = ESTIMATOR_HYSTERESIS;
+    struct log_reader_t reader;
+    struct bin_log_block_t block;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:e:H:h")) != -1) {
+        switch (opt) {
+        case 's':
+            from_ms = strtoll(optarg, NULL, 10);
+            break;
+        case 'e':
+            to_ms = strtoll(optarg, NULL, 10);
+            break;
+        case 'H':
+            hysteresis = atoi(optarg);
+            break;
+        default:
+            optind = argc;
+            break;
+        }
+    }
+
+    if (argc - optind != 1) {
+        fprintf(stderr, "Usage: %s [-s from_ms] [-e to_ms] [-H hysteresis_tenths] <Log>\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    if (openLogReader(&reader, argv[optind], from_ms, to_ms) < 0) {
+        fprintf(stderr, "No log lines found in %s\n", argv[optind]);
+        exit(EXIT_FAILURE);
+    }
+
+    struct channel_stats_t *stats = calloc(reader.channels, sizeof(*stats));
+    if (stats == NULL) {
+        error_exit("Calloc failed");
+    }
+    for (uint32_t ch = 0; ch < reader.channels; ++ch) {
+        stats[ch].min = INT32_MAX;
+        stats[ch].max = INT32_MIN + 1;
+    }
+
+    while (readLogBlock(&reader, &block) > 0) {
+        for (uint32_t ch = 0; ch < reader.channels; ++ch) {
+            const int32_t *values = &block.values[ch * block.stride];
+            accumulateValues(&stats[ch], values, block.rows);
+            countCrossings(&stats[ch], block.timestamps, values, block.rows, hysteresis);
+            measurePeriods(&stats[ch], block.timestamps, values, block.rows);
+        }
+    }
+
+    for (uint32_t ch = 0; ch < reader.channels; ++ch) {
+        char name[24];
+        if (reader.flags & BIN_LOG_KEYS_DATA) {
+            snprintf(name, sizeof(name), "data");
+        } else {
+            snprintf(name, sizeof(name), "out%u", ch + 1);
+        }
+        printStats(name, &stats[ch]);
+    }
+
+    free(stats);
+    closeLogReader(&reader);
+    return 0;
+}
@@ -0,0 +1,590 @@
+/*****************************************************************************/
+/**
+*  Brief: 	Simulates the signal server for local testing. Every channel listens
+*           on its own TCP port and streams values in the server text format
+*           ("-2.9\n"), channels cycle through sine, triangle and square outputs
+*           like ports 4001 ... 4003. The outputs are controlled over the UDP
+*           control protocol, object N is channel N.
+*
+*  Created: 16.10.2026
+*  Author: 	Yurii Shenbor
+*
+******************************************************************************/
+
+/***************************** Include Files ********************************/
+
+#define _GNU_SOURCE     // accept4, recvmmsg, sendmmsg
+
+#include "../lib/control.h"
+#include "../lib/stats.h"
+#include <getopt.h>
+#include <math.h>
+#include <signal.h>
+#include <sys/resource.h>
+
+/************************** Constant Definitions *****************************/
+
+#define SINE_TABLE_BITS     12
+#define SINE_TABLE_SIZE     (1 << SINE_TABLE_BITS)
+#define WRITE_MAX           8192        // Bytes written to a connection per tick
+#define UDP_BATCH           64          // Control messages received at once
+#define WORKERS_MAX         64
+
+enum shape_e {
+    SHAPE_SINE,
+    SHAPE_TRIANGLE,
+    SHAPE_SQUARE
+};
+
+/**************************** Type Definitions *******************************/
+
+// Properties of an output, written by the control thread and read by the workers
+struct sim_output_t {
+    uint32_t shape;
+    _Atomic uint16_t enabled;
+    _Atomic uint16_t amplitude;         // millivolts
+    _Atomic uint16_t frequency;         // millihertz
+    _Atomic uint16_t glitch_chance;     // per mille of samples replaced with noise
+    _Atomic uint16_t min_duration;      // milliseconds, square only
+    _Atomic uint16_t max_duration;      // milliseconds, square only
+};
+
+// Client connection with its own signal generator
+struct connection_t {
+    int sockfd;
+    struct sim_output_t *output;
+    uint64_t start_ns;
+    uint64_t produced;                  // samples generated since the connection
+    uint32_t phase;                     // 2^32 is a full period
+    int32_t level;                      // square only
+    uint64_t switch_at;                 // sample of the next square level change
+    uint32_t partial_size;
+    char partial[SAMPLE_TEXT_SIZE];     // rest of a line the socket did not take
+};
+
+struct worker_t {
+    int epfd;
+    int timerfd;
+    int *listenfd;                      // listening sockets of the channels of the worker
+    struct sim_output_t **listen_output;
+    size_t listen_count;
+    struct connection_t *connections;
+    size_t count;
+    size_t capacity;
+    uint64_t rng;
+};
+
+/************************** Variable Definitions *****************************/
+
+static int16_t sine_table[SINE_TABLE_SIZE];
+static unsigned long sample_rate = 1000;
+static unsigned long tick_us = 1000;
+
+/************************** Function Prototypes ******************************/
+
+static uint32_t nextRandom(uint64_t *state);
+static int32_t nextSample(struct worker_t *worker, struct connection_t *conn);
+static void skipSamples(struct connection_t *conn, uint64_t count);
+static void serveConnection(struct worker_t *worker, struct connection_t *conn, uint64_t now_ns);
+static void acceptConnections(struct worker_t *worker, int listenfd, struct sim_output_t *output);
+static void* runWorker(void *args);
+static void runControl(int sockfd, struct sim_output_t *outputs, size_t count);
+static _Atomic uint16_t* findOutputProperty(struct sim_output_t *output, uint16_t property);
+
+/**************************************************************************/
+/**
+*
+* @brief    Gets a pseudo-random number (xorshift64*)
+*
+**************************************************************************/
+static uint32_t nextRandom(uint64_t *state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return (*state * 0x2545F4914F6CDD1Dull) >> 32;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Generates the next sample of a connection
+*
+* @param	worker - worker that serves the connection
+* @param	conn - the connection
+*
+* @return	value in tenths of a volt
+*
+* @note		Property changes take effect at the current phase, so the signal
+*           stays continuous.
+*
+**************************************************************************/
+static int32_t nextSample(struct worker_t *worker, struct connection_t *conn) {
+    struct sim_output_t *output = conn->output;
+    int32_t amplitude = atomic_load_explicit(&output->amplitude, memory_order_relaxed) / 100;
+    uint32_t glitch = atomic_load_explicit(&output->glitch_chance, memory_order_relaxed);
+    int32_t value;
+
+    switch (output->shape) {
+    case SHAPE_SINE:
+        value = (amplitude * sine_table[conn->phase >> (32 - SINE_TABLE_BITS)]) / 32767;
+        break;
+    case SHAPE_TRIANGLE: {
+        // -A at phase 0, +A at half of the period
+        int64_t ramp = (conn->phase < 0x80000000u) ? conn->phase : 0xFFFFFFFFu - conn->phase;
+        value = -amplitude + (int32_t)((2 * amplitude * ramp) >> 31);
+        break;
+    }
+    default:
+        if (conn->produced >= conn->switch_at) {
+            uint32_t min_ms = atomic_load_explicit(&output->min_duration, memory_order_relaxed);
+            uint32_t max_ms = atomic_load_explicit(&output->max_duration, memory_order_relaxed);
+            uint32_t duration_ms = min_ms + ((max_ms > min_ms) ? nextRandom(&worker->rng) % (max_ms - min_ms + 1) : 0);
+            conn->level = conn->level ? 0 : 50;
+            conn->switch_at = conn->produced + (duration_ms * sample_rate) / 1000 + 1;
+        }
+        value = conn->level;
+        amplitude = 50;
+        break;
+    }
+
+    conn->phase += (uint32_t)(((uint64_t)atomic_load_explicit(&output->frequency, memory_order_relaxed) << 32) / (1000 * sample_rate));
+    conn->produced++;
+
+    if (glitch > 0 && nextRandom(&worker->rng) % 1000 < glitch) {
+        value = (int32_t)(nextRandom(&worker->rng) % (2 * amplitude + 1)) - amplitude;
+    }
+    return value;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Advances the generator of a connection without producing samples
+*
+* @param	conn - the connection
+* @param	count - number of samples to skip
+*
+* @return	None
+*
+**************************************************************************/
+static void skipSamples(struct connection_t *conn, uint64_t count) {
+    uint64_t step = ((uint64_t)atomic_load_explicit(&conn->output->frequency, memory_order_relaxed) << 32) / (1000 * sample_rate);
+
+    conn->phase += (uint32_t)(step * count);
+    conn->produced += count;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Sends all samples of a connection that are due
+*
+* @param	worker - worker that serves the connection
+* @param	conn - the connection
+* @param	now_ns - current monotonic time
+*
+* @return	None
+*
+* @note		If the client does not keep up or the output is disabled, samples are
+*           skipped so the stream stays in real time. A failed connection is
+*           closed (sockfd -1).
+*
+**************************************************************************/
+static void serveConnection(struct worker_t *worker, struct connection_t *conn, uint64_t now_ns) {
+    char buffer[SAMPLE_TEXT_SIZE + WRITE_MAX + SAMPLE_TEXT_SIZE];
+    uint64_t due = (now_ns - conn->start_ns) / 1000 * sample_rate / 1000000;
+    size_t used = conn->partial_size;
+
+    memcpy(buffer, conn->partial, conn->partial_size);
+    if (atomic_load_explicit(&conn->output->enabled, memory_order_relaxed)) {
+        while (conn->produced < due && used < WRITE_MAX) {
+            used += formatSample((struct sample_t){nextSample(worker, conn), 1}, &buffer[used]);
+            buffer[used++] = '\n';
+        }
+    }
+    if (conn->produced < due) {
+        skipSamples(conn, due - conn->produced);
+    }
+    if (used == 0) {
+        return;
+    }
+
+    ssize_t sent = send(conn->sockfd, buffer, used, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (sent < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            close(conn->sockfd);
+            conn->sockfd = -1;
+            return;
+        }
+        sent = 0;
+    }
+
+    // The rest of a line already started is kept until it is fully written
+    if ((size_t)sent < conn->partial_size) {
+        memmove(conn->partial, &conn->partial[sent], conn->partial_size - sent);
+        conn->partial_size -= sent;
+        return;
+    }
+
+    // Lines that were not taken are dropped, except the rest of a line already started
+    conn->partial_size = 0;
+    if (sent > 0 && (size_t)sent < used && buffer[sent - 1] != '\n') {
+        const char *end = memchr(&buffer[sent], '\n', used - sent);
+        conn->partial_size = end + 1 - &buffer[sent];
+        memcpy(conn->partial, &buffer[sent], conn->partial_size);
+    }
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Accepts all pending connections of a channel
+*
+* @param	worker - worker that owns the channel
+* @param	listenfd - listening socket of the channel
+* @param	output - output of the channel
+*
+* @return	None
+*
+**************************************************************************/
+static void acceptConnections(struct worker_t *worker, int listenfd, struct sim_output_t *output) {
+    int sockfd;
+
+    while ((sockfd = accept4(listenfd, NULL, NULL, SOCK_NONBLOCK)) >= 0) {
+        if (worker->count == worker->capacity) {
+            size_t capacity = worker->capacity ? worker->capacity * 2 : 64;
+            void *ptr = realloc(worker->connections, capacity * sizeof(*worker->connections));
+            if (ptr == NULL) {
+                error_exit("Unable to grow connections");
+            }
+            worker->connections = ptr;
+            worker->capacity = capacity;
+        }
+
+        struct connection_t *conn = &worker->connections[worker->count++];
+        memset(conn, 0, sizeof(*conn));
+        conn->sockfd = sockfd;
+        conn->output = output;
+        conn->start_ns = monotonicNs();
+    }
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Serves the channels of a worker, in a thread
+*
+* @param	args - worker state
+*
+* @return	None
+*
+* @note		Samples of all connections are written once per tick, every
+*           connection gets the samples due since the previous tick in one write.
+*
+**************************************************************************/
+static void* runWorker(void *args) {
+    struct worker_t *worker = (struct worker_t *)args;
+    struct epoll_event events[EVENT_BATCH];
+
+    while (1) {
+        int count = epoll_wait(worker->epfd, events, EVENT_BATCH, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            error_exit("Epoll wait failed");
+        }
+
+        for (int i = 0; i < count; ++i) {
+            if (events[i].data.u64 < worker->listen_count) {
+                acceptConnections(worker, worker->listenfd[events[i].data.u64], worker->listen_output[events[i].data.u64]);
+                continue;
+            }
+
+            uint64_t expirations;
+            if (read(worker->timerfd, &expirations, sizeof(expirations)) < 0) {
+                continue;
+            }
+
+            uint64_t now_ns = monotonicNs();
+            for (size_t j = 0; j < worker->count; ) {
+                serveConnection(worker, &worker->connections[j], now_ns);
+                if (worker->connections[j].sockfd < 0) {
+                    worker->connections[j] = worker->connections[--worker->count];
+                } else {
+                    j++;
+                }
+            }
+        }
+    }
+
+    return NULL;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Finds a property of an output
+*
+* @param	output - the output
+* @param	property - the property
+*
+* @return	the property, NULL if the output does not have it
+*
+* @note		Square outputs have durations instead of amplitude and frequency.
+*
+**************************************************************************/
+static _Atomic uint16_t* findOutputProperty(struct sim_output_t *output, uint16_t property) {
+    int square = (output->shape == SHAPE_SQUARE);
+
+    switch (property) {
+    case ENABLED:
+        return &output->enabled;
+    case AMPLITUDE:
+        return square ? NULL : &output->amplitude;
+    case FREQUENCY:
+        return square ? NULL : &output->frequency;
+    case GLITCH_CHANCE:
+        return square ? NULL : &output->glitch_chance;
+    case MIN_DURATION:
+        return square ? &output->min_duration : NULL;
+    case MAX_DURATION:
+        return square ? &output->max_duration : NULL;
+    default:
+        return NULL;
+    }
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Serves the UDP control protocol
+*
+* @param	sockfd - bound UDP socket
+* @param	outputs - outputs of all channels, object N is outputs[N - 1]
+* @param	count - number of channels
+*
+* @return	None
+*
+* @note		A READ of an existing property is answered with the request and the
+*           value, anything else is not answered. Messages are received and the
+*           replies sent in batches.
+*
+**************************************************************************/
+static void runControl(int sockfd, struct sim_output_t *outputs, size_t count) {
+    uint8_t requests[UDP_BATCH][16];
+    uint8_t replies[UDP_BATCH][CONTROL_MSG_MAX];
+    struct sockaddr_in addr[UDP_BATCH];
+    struct mmsghdr headers[UDP_BATCH], reply_headers[UDP_BATCH];
+    struct iovec iov[UDP_BATCH], reply_iov[UDP_BATCH];
+
+    while (1) {
+        memset(headers, 0, sizeof(headers));
+        for (int i = 0; i < UDP_BATCH; ++i) {
+            iov[i] = (struct iovec){requests[i], sizeof(requests[i])};
+            headers[i].msg_hdr.msg_name = &addr[i];
+            headers[i].msg_hdr.msg_namelen = sizeof(addr[i]);
+            headers[i].msg_hdr.msg_iov = &iov[i];
+            headers[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        int received = recvmmsg(sockfd, headers, UDP_BATCH, MSG_WAITFORONE, NULL);
+        if (received < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            error_exit("Recvmmsg failed");
+        }
+
+        int reply_count = 0;
+        for (int i = 0; i < received; ++i) {
+            const uint8_t *msg = requests[i];
+            if (headers[i].msg_len < 6) {
+                continue;
+            }
+
+            uint16_t operation = (msg[0] << 8) | msg[1];
+            uint16_t object = (msg[2] << 8) | msg[3];
+            uint16_t property = (msg[4] << 8) | msg[5];
+            if (object == 0 || object > count) {
+                continue;
+            }
+            _Atomic uint16_t *field = findOutputProperty(&outputs[object - 1], property);
+            if (field == NULL) {
+                continue;
+            }
+
+            if (operation == WRITE && headers[i].msg_len >= 8) {
+                atomic_store_explicit(field, (msg[6] << 8) | msg[7], memory_order_relaxed);
+            } else if (operation == READ) {
+                uint16_t value = atomic_load_explicit(field, memory_order_relaxed);
+                memcpy(replies[reply_count], msg, 6);
+                replies[reply_count][6] = value >> 8;
+                replies[reply_count][7] = value & 0xFF;
+                reply_iov[reply_count] = (struct iovec){replies[reply_count], 8};
+                memset(&reply_headers[reply_count], 0, sizeof(reply_headers[0]));
+                reply_headers[reply_count].msg_hdr.msg_name = &addr[i];
+                reply_headers[reply_count].msg_hdr.msg_namelen = headers[i].msg_hdr.msg_namelen;
+                reply_headers[reply_count].msg_hdr.msg_iov = &reply_iov[reply_count];
+                reply_headers[reply_count].msg_hdr.msg_iovlen = 1;
+                reply_count++;
+            }
+        }
+
+        for (int sent = 0; sent < reply_count; ) {
+            int status = sendmmsg(sockfd, &reply_headers[sent], reply_count - sent, 0);
+            if (status < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                break;
+            }
+            sent += status;
+        }
+    }
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Main function for the signal server simulator.
+*
+* @param	None
+*
+* @return	None
+*
+* @note		Runs until killed.
+*
+**************************************************************************/
+int main(int argc, char *argv[]) {
+    unsigned long channel_count = MAX_PORTS, base_port = TCP_PORT, udp_port = UDP_PORT, worker_count = 1;
+    struct worker_t workers[WORKERS_MAX];
+    pthread_t threads[WORKERS_MAX];
+    int opt;
+
+    while ((opt = getopt(argc, argv, "i:n:p:r:t:u:h")) != -1) {
+        switch (opt) {
+        case 'i':
+            tick_us = strtoul(optarg, NULL, 10);
+            break;
+        case 'n':
+            channel_count = strtoul(optarg, NULL, 10);
+            break;
+        case 'p':
+            base_port = strtoul(optarg, NULL, 10);
+            break;
+        case 'r':
+            sample_rate = strtoul(optarg, NULL, 10);
+            break;
+        case 't':
+            worker_count = strtoul(optarg, NULL, 10);
+            break;
+        case 'u':
+            udp_port = strtoul(optarg, NULL, 10);
+            break;
+        default:
+            optind = argc + 1;
+            break;
+        }
+    }
+
+    if (optind != argc || channel_count == 0 || base_port + channel_count - 1 > 65535 || udp_port > 65535 ||
+        sample_rate == 0 || tick_us == 0 || worker_count == 0 || worker_count > WORKERS_MAX) {
+        fprintf(stderr, "Usage: %s [-n channels] [-p first_tcp_port] [-u udp_port] [-r samples_per_sec] [-i tick_us] [-t threads]\n"
+                        "  -n  number of channels, 3 by default\n"
+                        "  -p  port of the first channel, 4001 by default, every channel has the next one\n"
+                        "  -u  port of the control protocol, 4000 by default\n"
+                        "  -r  samples per second of every channel, 1000 by default\n"
+                        "  -i  period of the writes, 1000us by default\n"
+                        "  -t  threads serving the channels, 1 by default\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    if (worker_count > channel_count) {
+        worker_count = channel_count;
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    for (int i = 0; i < SINE_TABLE_SIZE; ++i) {
+        sine_table[i] = lround(32767 * sin(2 * M_PI * i / SINE_TABLE_SIZE));
+    }
+
+    // Outputs cycle through the shapes and defaults of the real server
+    struct sim_output_t *outputs = calloc(channel_count, sizeof(*outputs));
+    if (outputs == NULL) {
+        error_exit("Calloc failed");
+    }
+    for (size_t i = 0; i < channel_count; ++i) {
+        outputs[i].shape = i % 3;
+        outputs[i].enabled = 1;
+        outputs[i].amplitude = 5000;
+        outputs[i].frequency = (i % 3 == SHAPE_SINE) ? 500 : 250;
+        outputs[i].glitch_chance = (i % 3 == SHAPE_SINE) ? 60 : (i % 3 == SHAPE_TRIANGLE) ? 5 : 0;
+        outputs[i].min_duration = 1000;
+        outputs[i].max_duration = 5000;
+    }
+
+    // Channels are split between the workers round-robin
+    struct itimerspec period = {.it_interval = {tick_us / 1000000, (tick_us % 1000000) * 1000}};
+    period.it_value = period.it_interval;
+    for (size_t w = 0; w < worker_count; ++w) {
+        struct worker_t *worker = &workers[w];
+        memset(worker, 0, sizeof(*worker));
+        worker->rng = 0x9E3779B97F4A7C15ull * (w + 1);
+        worker->listenfd = calloc(channel_count / worker_count + 1, sizeof(*worker->listenfd));
+        worker->listen_output = calloc(channel_count / worker_count + 1, sizeof(*worker->listen_output));
+        if ((worker->epfd = epoll_create1(0)) < 0 || (worker->timerfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK)) < 0 ||
+            worker->listenfd == NULL || worker->listen_output == NULL) {
+            error_exit("Unable to start worker");
+        }
+    }
+
+    for (size_t i = 0; i < channel_count; ++i) {
+        struct worker_t *worker = &workers[i % worker_count];
+        struct sockaddr_in addr = {.sin_family = AF_INET, .sin_port = htons(base_port + i), .sin_addr.s_addr = htonl(INADDR_ANY)};
+        int one = 1;
+        int listenfd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+
+        setsockopt(listenfd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (listenfd < 0 || bind(listenfd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(listenfd, SOMAXCONN) < 0) {
+            fprintf(stderr, "Unable to listen on port %lu: %s\n", base_port + i, strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+
+        struct epoll_event event = {.events = EPOLLIN, .data.u64 = worker->listen_count};
+        worker->listenfd[worker->listen_count] = listenfd;
+        worker->listen_output[worker->listen_count] = &outputs[i];
+        worker->listen_count++;
+        if (epoll_ctl(worker->epfd, EPOLL_CTL_ADD, listenfd, &event) < 0) {
+            error_exit("Epoll ctl failed");
+        }
+    }
+
+    for (size_t w = 0; w < worker_count; ++w) {
+        struct epoll_event event = {.events = EPOLLIN, .data.u64 = workers[w].listen_count};
+        if (epoll_ctl(workers[w].epfd, EPOLL_CTL_ADD, workers[w].timerfd, &event) < 0 ||
+            timerfd_settime(workers[w].timerfd, 0, &period, NULL) < 0) {
+            error_exit("Unable to start timer");
+        }
+        if (pthread_create(&threads[w], NULL, runWorker, &workers[w]) != 0) {
+            error_exit("Unable to start worker");
+        }
+    }
+
+    struct sockaddr_in udp_addr = {.sin_family = AF_INET, .sin_port = htons(udp_port), .sin_addr.s_addr = htonl(INADDR_ANY)};
+    int udp_sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (udp_sockfd < 0 || bind(udp_sockfd, (struct sockaddr *)&udp_addr, sizeof(udp_addr)) < 0) {
+        error_exit("Unable to bind control port");
+    }
+
+    fprintf(stderr, "Serving %lu channels on TCP ports %lu ... %lu at %lu samples/s, control on UDP port %lu\n",
+            channel_count, base_port, base_port + channel_count - 1, sample_rate, udp_port);
+    runControl(udp_sockfd, outputs, channel_count);
+
+    return 0;
+}
@@ -0,0 +1,209 @@
+/*****************************************************************************/
+/**
+*  Brief: 	Prints the hot-path metrics a running client publishes in /dev/shm.
+*
+*  Created: 16.10.2026
+*  Author: 	Yurii Shenbor
+*
+******************************************************************************/
+
+/***************************** Include Files ********************************/
+
+#include "../lib/client_lib.h"
+#include "../lib/stats.h"
+#include <getopt.h>
+#include <dirent.h>
+#include <signal.h>
+#include <sys/mman.h>
+
+/************************** Constant Definitions *****************************/
+
+#define SHM_DIR     "/dev/shm"
+
+/**************************************************************************/
+/**
+*
+* @brief    Prints a histogram summary as a JSON object
+*
+* @param	name - key of the object
+* @param	histogram - the histogram
+*
+* @return	None
+*
+**************************************************************************/
+static void printHistogram(const char *name, const struct stats_histogram_t *histogram) {
+    uint64_t count = atomic_load_explicit(&histogram->count, memory_order_relaxed);
+    uint64_t sum = atomic_load_explicit(&histogram->sum, memory_order_relaxed);
+
+    printf("\"%s\": {\"count\": %lu, \"mean\": %lu, \"p50\": %lu, \"p99\": %lu, \"p99.9\": %lu, \"max\": %lu}",
+           name, count, count ? sum / count : 0, statsPercentile(histogram, 50), statsPercentile(histogram, 99),
+           statsPercentile(histogram, 99.9), atomic_load_explicit(&histogram->max, memory_order_relaxed));
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Prints the metrics of a client as a single JSON line
+*
+* @param	stats - metrics block
+* @param	ports - print metrics of every port, otherwise only the totals
+*
+* @return	None
+*
+**************************************************************************/
+static void printStats(const struct stats_t *stats, int ports) {
+    uint64_t bytes = 0, reads = 0, samples = 0, missing = 0, closed = 0;
+
+    for (uint32_t i = 0; i < stats->port_count; ++i) {
+        bytes += atomic_load_explicit(&stats->ports[i].bytes, memory_order_relaxed);
+        reads += atomic_load_explicit(&stats->ports[i].reads, memory_order_relaxed);
+        samples += atomic_load_explicit(&stats->ports[i].samples, memory_order_relaxed);
+        missing += atomic_load_explicit(&stats->ports[i].missing, memory_order_relaxed);
+        closed += atomic_load_explicit(&stats->ports[i].closed, memory_order_relaxed);
+    }
+
+    printf("{\"pid\": %d, \"tick_period_ns\": %lu, \"ticks\": %lu, \"overruns\": %lu, ",
+           stats->pid, stats->tick_period_ns, atomic_load_explicit(&stats->ticks, memory_order_relaxed),
+           atomic_load_explicit(&stats->overruns, memory_order_relaxed));
+    printHistogram("tick_ns", &stats->tick_ns);
+    printf(", ");
+    printHistogram("tick_lag_ns", &stats->tick_lag_ns);
+    printf(", \"messages\": %lu, \"send_errors\": %lu, ",
+           atomic_load_explicit(&stats->messages, memory_order_relaxed),
+           atomic_load_explicit(&stats->send_errors, memory_order_relaxed));
+    printHistogram("send_ns", &stats->send_ns);
+    printf(", \"acks\": %lu, \"ack_mismatches\": %lu, \"ack_timeouts\": %lu, ",
+           atomic_load_explicit(&stats->acks, memory_order_relaxed),
+           atomic_load_explicit(&stats->ack_mismatches, memory_order_relaxed),
+           atomic_load_explicit(&stats->ack_timeouts, memory_order_relaxed));
+    printHistogram("ack_ns", &stats->ack_ns);
+    printf(", ");
+    printHistogram("react_ns", &stats->react_ns);
+    printf(", \"port_count\": %u, \"bytes\": %lu, \"reads\": %lu, \"samples\": %lu, \"missing\": %lu, \"closed\": %lu",
+           stats->port_count, bytes, reads, samples, missing, closed);
+
+    if (ports) {
+        printf(", \"ports\": [");
+        for (uint32_t i = 0; i < stats->port_count; ++i) {
+            const struct port_stats_t *port = &stats->ports[i];
+            printf("%s{\"port\": %u, \"bytes\": %lu, \"reads\": %lu, \"samples\": %lu, \"missing\": %lu, \"closed\": %lu, ",
+                   i ? ", " : "", i + 1, atomic_load_explicit(&port->bytes, memory_order_relaxed),
+                   atomic_load_explicit(&port->reads, memory_order_relaxed),
+                   atomic_load_explicit(&port->samples, memory_order_relaxed),
+                   atomic_load_explicit(&port->missing, memory_order_relaxed),
+                   atomic_load_explicit(&port->closed, memory_order_relaxed));
+            printHistogram("read_ns", &port->read_ns);
+            uint64_t period_ns = atomic_load_explicit(&port->period_ns, memory_order_relaxed);
+            printf(", \"periods\": %lu, \"frequency_hz\": %.3f, \"amplitude\": %.1f, \"shape\": \"%s\"}",
+                   atomic_load_explicit(&port->periods, memory_order_relaxed),
+                   period_ns ? 1e9 / period_ns : 0.0,
+                   atomic_load_explicit(&port->amplitude, memory_order_relaxed) / 10.0,
+                   shapeName(atomic_load_explicit(&port->shape, memory_order_relaxed)));
+        }
+        printf("]");
+    }
+
+    printf("}\n");
+    fflush(stdout);
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Lists metrics blocks in /dev/shm
+*
+* @param	remove_stale - remove blocks and rings of processes that no longer run
+*
+* @return	None
+*
+* @note		A killed client can't remove its block.
+*
+**************************************************************************/
+static void listStats(int remove_stale) {
+    const char *prefix = STATS_SHM_PREFIX + 1;
+    DIR *dir = opendir(SHM_DIR);
+    struct dirent *entry;
+
+    if (dir == NULL) {
+        error_exit("Unable to open " SHM_DIR);
+    }
+
+    while ((entry = readdir(dir)) != NULL) {
+        if (strncmp(entry->d_name, prefix, strlen(prefix)) != 0) {
+            continue;
+        }
+
+        // Other segments of a client (i.e. its rings) have a suffix after the pid
+        char *suffix;
+        int pid = strtol(entry->d_name + strlen(prefix), &suffix, 10);
+        int alive = (kill(pid, 0) == 0 || errno == EPERM);
+        if (*suffix == '\0') {
+            printf("{\"pid\": %d, \"alive\": %s}\n", pid, alive ? "true" : "false");
+        }
+
+        if (!alive && remove_stale) {
+            char name[300];
+            snprintf(name, sizeof(name), "/%s", entry->d_name);
+            shm_unlink(name);
+        }
+    }
+
+    closedir(dir);
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Main function for metrics reader.
+*
+* @param	None
+*
+* @return	None
+*
+* @note		Reading the block doesn't affect the client in any way.
+*
+**************************************************************************/
+int main(int argc, char *argv[]) {
+    unsigned long interval_ms = 0;
+    int ports = 0, remove_stale = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "i:prh")) != -1) {
+        switch (opt) {
+        case 'i':
+            interval_ms = strtoul(optarg, NULL, 10);
+            break;
+        case 'p':
+            ports = 1;
+            break;
+        case 'r':
+            remove_stale = 1;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-r]                   list clients, remove blocks of stopped ones\n"
+                            "       %s [-i interval_ms] [-p] <Pid>  print metrics, per port with -p\n", argv[0], argv[0]);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if (optind == argc) {
+        listStats(remove_stale);
+        return 0;
+    }
+
+    size_t size;
+    struct stats_t *stats = mapStats(atoi(argv[optind]), &size);
+    if (stats == NULL) {
+        error_exit("Unable to map metrics");
+    }
+
+    do {
+        printStats(stats, ports);
+        if (interval_ms > 0) {
+            usleep(interval_ms * 1000);
+        }
+    } while (interval_ms > 0);
+
+    munmap(stats, size);
+    return 0;
+}
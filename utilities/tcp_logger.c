@@ -10,6 +10,75 @@
 /***************************** Include Files ********************************/
 
 #include "../lib/client_lib.h"
+#include "../lib/output.h"
+#include "../lib/bin_log.h"
+#include <poll.h>
+
+/************************** Constant Definitions *****************************/
+
+#define LOG_FLUSH_LINES     256     // Lines buffered before a write
+#define LOG_FLUSH_MS        1000UL  // Longest time a line may stay buffered
+
+/**************************************************************************/
+/**
+*
+* @brief    Gets the time a sample was received
+*
+* @param	port - port the sample was received from
+*
+* @return	time in milliseconds since the epoch
+*
+* @note		The kernel arrival time is used if the socket has receive timestamps,
+*           so the scheduling delay of the logger is not included.
+*
+**************************************************************************/
+static int64_t sampleTime(const struct port_t *port) {
+    struct timeval time;
+
+    if (port->rx_ns != 0) {
+        return port->rx_ns / 1000000;
+    }
+    gettimeofday(&time, NULL);
+    return ((int64_t)time.tv_sec * 1000) + (time.tv_usec / 1000);
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Writes a single sample received from the port into the log
+*
+* @param	port - port the sample was received from
+* @param	sample - the received value
+* @param	ctx - log writer
+*
+* @return	None
+*
+* @note		None
+*
+**************************************************************************/
+static void logSample(struct port_t *port, struct sample_t sample, void *ctx) {
+    writeLogRecord((struct output_t *)ctx, sampleTime(port), sample);
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Writes a single sample received from the port into the binary log
+*
+* @param	port - port the sample was received from
+* @param	sample - the received value
+* @param	ctx - binary log writer
+*
+* @return	None
+*
+* @note		None
+*
+**************************************************************************/
+static void logBinarySample(struct port_t *port, struct sample_t sample, void *ctx) {
+    if (appendBinLog((struct bin_log_t *)ctx, sampleTime(port), &sample) < 0) {
+        error_exit("Unable to write binary log");
+    }
+}
 
 /**************************************************************************/
 /**
@@ -24,18 +93,22 @@
 *
 **************************************************************************/
 int main(int argc, char *argv[]) {
-    if (argc != 3) {
-        fprintf(stderr, "Usage: %s <Port> <Duration_sec>\n", argv[0]);
+    if (argc < 3 || argc > 4 || (argc == 4 && strcmp(argv[3], "json") != 0 && strcmp(argv[3], "bin") != 0 &&
+                                 strcmp(argv[3], "zbin") != 0)) {
+        fprintf(stderr, "Usage: %s <Port> <Duration_sec> [json|bin|zbin]\n", argv[0]);
         exit(EXIT_FAILURE);
     }
 
-    char buffer[BUFFER_SIZE];
+    struct port_t port = {0};
+    struct output_t output;
+    struct bin_log_t bin_log;
     struct timeval time;
     unsigned long int current_time_msec, duration_msec;
-    int bytes_received = 0;
 
     int port_number = atoi(argv[1]);
     int duration_sec = atoi(argv[2]);
+    int binary = (argc == 4 && strcmp(argv[3], "json") != 0);
+    uint16_t flags = (argc == 4 && strcmp(argv[3], "zbin") == 0) ? BIN_LOG_KEYS_DATA | BIN_LOG_COMPRESSED : BIN_LOG_KEYS_DATA;
 
     struct sockaddr_in server_addr;
     if (findOpenPort(port_number, &server_addr) < 0) {
@@ -43,14 +116,32 @@ int main(int argc, char *argv[]) {
     }
     
     printf("Connecting to port %d...\n", port_number);
-    int sockfd = connectToPort(&server_addr, 1);
+    if ((port.sockfd = connectToPort(&server_addr, 1)) < 0) {
+        error_exit("Unable to connect");
+    }
+    if (enableTimestamps(&port) < 0) {
+        fprintf(stderr, "Kernel receive timestamps are not supported, the receive time is used\n");
+    }
 
     char file_name[32];
     strcpy(file_name, argv[1]);
-    strcat(file_name, ".log");
-    FILE *fp = fopen(file_name, "w");
-    if (!fp) {
-        error_exit("Unable to open file");
+    strcat(file_name, binary ? ".bin" : ".log");
+    if (binary) {
+        if (openBinLog(&bin_log, file_name, 1, 0, flags) < 0) {
+            error_exit("Unable to open file");
+        }
+        port.on_sample = logBinarySample;
+        port.ctx = &bin_log;
+    } else {
+        int fd = open(file_name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            error_exit("Unable to open file");
+        }
+        if (initOutput(&output, fd, 0, LOG_FLUSH_LINES, LOG_FLUSH_MS) < 0) {
+            error_exit("Unable to allocate output");
+        }
+        port.on_sample = logSample;
+        port.ctx = &output;
     }
 
     gettimeofday(&time, NULL);
@@ -58,22 +149,34 @@ int main(int argc, char *argv[]) {
                     ((unsigned long int)duration_sec * 1000);
 
     while (1) {
-        bytes_received = recv(sockfd, buffer, sizeof(buffer) - 1, 0);
-        if (bytes_received > 0) {
-            buffer[bytes_received - 1] = '\0';
-            
-            gettimeofday(&time, NULL);
-            current_time_msec = ((unsigned long int)time.tv_sec * 1000) + ((unsigned long int)time.tv_usec / 1000);
-            fprintf(fp, "{\"timestamp\": %lu, \"data\": \"%s\"}\n", current_time_msec, buffer);
-
-            if (current_time_msec >= duration_msec){
+        // Wait at most the flush period, so buffered lines are written while the stream stalls
+        struct pollfd poll_fd = {port.sockfd, POLLIN, 0};
+        if (poll(&poll_fd, 1, LOG_FLUSH_MS) > 0) {
+            // Every sample received is logged, including several lines in one read
+            if (readFromPort(&port) <= 0) {
+                fprintf(stderr, "Connection closed\n");
                 break;
             }
         }
+
+        gettimeofday(&time, NULL);
+        current_time_msec = ((unsigned long int)time.tv_sec * 1000) + ((unsigned long int)time.tv_usec / 1000);
+        if (!binary) {
+            expireOutput(&output, current_time_msec);
+        }
+        if (current_time_msec >= duration_msec){
+            break;
+        }
     }
     
+    if (binary) {
+        closeBinLog(&bin_log);
+    } else {
+        int fd = output.fd;
+        closeOutput(&output);
+        close(fd);
+    }
     printf("Log saved into the file: %s\n", file_name);
-    fclose(fp);
-    close(sockfd);
+    close(port.sockfd);
     return 0;
 }
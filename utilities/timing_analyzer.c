@@ -0,0 +1,159 @@
+/*****************************************************************************/
+/**
+*  Brief: 	Measures tick timing of a client log in a single streaming pass:
+*           interval percentiles, accumulated drift, missed samples per channel
+*           and the longest gap. Reads JSON lines logs and binary logs.
+*
+*  Created: 16.10.2026
+*  Author: 	Yurii Shenbor
+*
+******************************************************************************/
+
+/***************************** Include Files ********************************/
+
+#include "../lib/client_lib.h"
+#include "../lib/log_reader.h"
+#include "../lib/histogram.h"
+#include <getopt.h>
+
+/**************************** Type Definitions *******************************/
+
+struct channel_timing_t {
+    uint64_t missing;                   // "--" values
+    uint64_t run;                       // current run of missing values
+    int64_t run_start_ms;               // timestamp where the current run started
+    uint64_t longest_run;               // longest run of missing values
+    int64_t longest_run_ms;             // timestamp where the longest run started
+};
+
+/**************************************************************************/
+/**
+*
+* @brief    Main function for timing analyzer.
+*
+* @param	None
+*
+* @return	EXIT_FAILURE if the interval limit is exceeded, otherwise EXIT_SUCCESS
+*
+* @note		Prints a single JSON object.
+*
+**************************************************************************/
+int main(int argc, char *argv[]) {
+    int64_t from_ms = INT64_MIN, to_ms = INT64_MAX;
+    uint64_t period_ms = 0, limit_ms = 0;
+    struct log_reader_t reader;
+    struct bin_log_block_t block;
+    static struct histogram_t intervals;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:e:p:l:h")) != -1) {
+        switch (opt) {
+        case 's':
+            from_ms = strtoll(optarg, NULL, 10);
+            break;
+        case 'e':
+            to_ms = strtoll(optarg, NULL, 10);
+            break;
+        case 'p':
+            period_ms = strtoull(optarg, NULL, 10);
+            break;
+        case 'l':
+            limit_ms = strtoull(optarg, NULL, 10);
+            break;
+        default:
+            optind = argc;
+            break;
+        }
+    }
+
+    if (argc - optind != 1) {
+        fprintf(stderr, "Usage: %s [-s from_ms] [-e to_ms] [-p period_ms] [-l p99.9_limit_ms] <Log>\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    if (openLogReader(&reader, argv[optind], from_ms, to_ms) < 0) {
+        fprintf(stderr, "No log lines found in %s\n", argv[optind]);
+        exit(EXIT_FAILURE);
+    }
+
+    struct channel_timing_t *channels = calloc(reader.channels, sizeof(*channels));
+    if (channels == NULL) {
+        error_exit("Calloc failed");
+    }
+
+    initHistogram(&intervals);
+    int64_t first_ms = 0, previous_ms = 0, gap_ms = 0;
+    uint64_t rows = 0, backwards = 0;
+
+    while (readLogBlock(&reader, &block) > 0) {
+        for (uint32_t row = 0; row < block.rows; ++row) {
+            int64_t timestamp = block.timestamps[row];
+
+            if (rows++ == 0) {
+                first_ms = timestamp;
+            } else if (timestamp < previous_ms) {
+                // The wall clock went back, the interval can't be measured
+                backwards++;
+            } else {
+                recordValue(&intervals, timestamp - previous_ms);
+                if ((uint64_t)(timestamp - previous_ms) == intervals.max) {
+                    gap_ms = previous_ms;
+                }
+            }
+            previous_ms = timestamp;
+        }
+
+        for (uint32_t ch = 0; ch < reader.channels; ++ch) {
+            const int32_t *values = &block.values[ch * block.stride];
+            struct channel_timing_t *channel = &channels[ch];
+
+            for (uint32_t row = 0; row < block.rows; ++row) {
+                if (values[row] != BIN_LOG_INVALID) {
+                    channel->run = 0;
+                    continue;
+                }
+                channel->missing++;
+                if (++channel->run == 1) {
+                    channel->run_start_ms = block.timestamps[row];
+                }
+                if (channel->run > channel->longest_run) {
+                    channel->longest_run = channel->run;
+                    channel->longest_run_ms = channel->run_start_ms;
+                }
+            }
+        }
+    }
+
+    if (period_ms == 0) {
+        period_ms = valueAtPercentile(&intervals, 50);
+    }
+
+    uint64_t p999 = valueAtPercentile(&intervals, 99.9);
+    int64_t drift_ms = (previous_ms - first_ms) - (int64_t)(intervals.count + backwards) * (int64_t)period_ms;
+
+    printf("{\"rows\": %lu, \"period_ms\": %lu, \"duration_ms\": %ld, \"drift_ms\": %ld, \"backwards\": %lu, "
+           "\"interval_ms\": {\"min\": %lu, \"mean\": %.3f, \"p50\": %lu, \"p90\": %lu, \"p99\": %lu, \"p99.9\": %lu, \"max\": %lu}, "
+           "\"longest_gap\": {\"ms\": %lu, \"at\": %ld}, \"channels\": [",
+           rows, period_ms, previous_ms - first_ms, drift_ms, backwards,
+           intervals.count ? intervals.min : 0, intervals.count ? (double)intervals.sum / intervals.count : 0.0,
+           valueAtPercentile(&intervals, 50), valueAtPercentile(&intervals, 90), valueAtPercentile(&intervals, 99),
+           p999, intervals.max, intervals.max, gap_ms);
+
+    for (uint32_t ch = 0; ch < reader.channels; ++ch) {
+        char name[24];
+        if (reader.flags & BIN_LOG_KEYS_DATA) {
+            snprintf(name, sizeof(name), "data");
+        } else {
+            snprintf(name, sizeof(name), "out%u", ch + 1);
+        }
+        printf("%s{\"channel\": \"%s\", \"missing\": %lu, \"longest_missing_run\": %lu, \"longest_missing_at\": %ld}",
+               ch ? ", " : "", name, channels[ch].missing, channels[ch].longest_run, channels[ch].longest_run_ms);
+    }
+
+    int failed = (limit_ms > 0 && p999 > limit_ms);
+    printf("], \"limit_ms\": %lu, \"passed\": %s}\n", limit_ms, failed ? "false" : "true");
+
+    free(channels);
+    closeLogReader(&reader);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
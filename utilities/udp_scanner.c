@@ -0,0 +1,411 @@
+/*****************************************************************************/
+/**
+*  Brief: 	Reads every property of the given objects over the UDP control
+*           protocol and prints the ones that exist with their values.
+*
+*           A window of requests is kept in flight, they are sent and the
+*           replies are received in batches. Every batch ends with a READ of a
+*           property that is known to exist (the fence). The server handles
+*           requests in order, so when the reply to a fence arrives, requests
+*           sent before it that are still unanswered either don't exist or were
+*           lost. They are retried at once instead of waiting for a timeout.
+*
+*  Created: 16.10.2026
+*  Author: 	Yurii Shenbor
+*
+******************************************************************************/
+
+/***************************** Include Files ********************************/
+
+#define _GNU_SOURCE     // sendmmsg, recvmmsg
+
+#include "../lib/control.h"
+#include "../lib/stats.h"
+#include <getopt.h>
+
+/************************** Constant Definitions *****************************/
+
+#define SCAN_BATCH          64              // Messages per sendmmsg and recvmmsg
+#define SCAN_PROPERTIES     65536           // Properties of every object
+#define SCAN_FENCE          UINT32_MAX      // Id of a fence in the in-flight ring
+#define SCAN_RCVBUF         (1 << 20)
+
+enum scan_state_e {
+    SCAN_UNSENT,
+    SCAN_PENDING,
+    SCAN_VALID,
+    SCAN_MISSING
+};
+
+/**************************** Type Definitions *******************************/
+
+// Sent request waiting for its reply
+struct inflight_t {
+    uint32_t id;                // (object - first_object) * 65536 + property, or SCAN_FENCE
+    uint64_t sent_ns;
+};
+
+struct scanner_t {
+    int sockfd;
+    struct sockaddr_in addr;
+    uint32_t first_object;
+    uint32_t count;             // number of requests to resolve
+    uint32_t next;              // next request never sent
+    uint32_t done;              // requests resolved
+    uint8_t *state;             // enum scan_state_e of every request
+    uint8_t *attempts;
+    uint16_t *value;
+    struct inflight_t *ring;    // sent requests in the order they were sent
+    uint32_t ring_mask;
+    uint32_t head;
+    uint32_t tail;
+    uint32_t *retry;            // requests to send again
+    uint32_t retry_count;
+    unsigned window;
+    unsigned retries;
+    uint64_t timeout_ns;
+    uint16_t fence_object;
+    uint16_t fence_property;
+    uint64_t sent;
+    uint64_t replies;
+    uint64_t resent;
+};
+
+/************************** Function Prototypes ******************************/
+
+static void expireRequest(struct scanner_t *scan, uint32_t id);
+static void sendBatch(struct scanner_t *scan);
+static int receiveReplies(struct scanner_t *scan);
+static void expireTimeouts(struct scanner_t *scan, uint64_t now_ns);
+
+/**************************************************************************/
+/**
+*
+* @brief    Handles a request that got no reply
+*
+* @param	scan - scanner state
+* @param	id - the request
+*
+* @return	None
+*
+* @note		The request is sent again until it runs out of retries, then the
+*           property is considered missing.
+*
+**************************************************************************/
+static void expireRequest(struct scanner_t *scan, uint32_t id) {
+    if (id == SCAN_FENCE || scan->state[id] != SCAN_PENDING) {
+        return;
+    }
+
+    if (scan->attempts[id] <= scan->retries) {
+        scan->retry[scan->retry_count++] = id;
+        scan->resent++;
+    } else {
+        scan->state[id] = SCAN_MISSING;
+        scan->done++;
+    }
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Sends as many requests as the window allows, followed by a fence
+*
+* @param	scan - scanner state
+*
+* @return	None
+*
+* @note		Queued retries that were answered meanwhile are not sent again,
+*           so every request completes exactly once.
+*
+**************************************************************************/
+static void sendBatch(struct scanner_t *scan) {
+    struct control_msg_t msgs[SCAN_BATCH];
+    struct mmsghdr headers[SCAN_BATCH];
+    struct iovec iov[SCAN_BATCH];
+    uint32_t ids[SCAN_BATCH];
+    unsigned count = 0;
+
+    while (count < SCAN_BATCH - 1 && scan->tail - scan->head + count < scan->window) {
+        uint32_t id;
+        if (scan->retry_count > 0) {
+            id = scan->retry[--scan->retry_count];
+            if (scan->state[id] == SCAN_VALID || scan->state[id] == SCAN_MISSING) {
+                // A late reply arrived while the request waited for its retry
+                continue;
+            }
+        } else if (scan->next < scan->count) {
+            id = scan->next++;
+        } else {
+            break;
+        }
+        encodeMessage(READ, scan->first_object + id / SCAN_PROPERTIES, id % SCAN_PROPERTIES, 0, &msgs[count]);
+        ids[count++] = id;
+    }
+    if (count == 0) {
+        return;
+    }
+    encodeMessage(READ, scan->fence_object, scan->fence_property, 0, &msgs[count]);
+    ids[count++] = SCAN_FENCE;
+
+    memset(headers, 0, count * sizeof(headers[0]));
+    for (unsigned i = 0; i < count; ++i) {
+        iov[i] = (struct iovec){msgs[i].data, msgs[i].size};
+        headers[i].msg_hdr.msg_name = &scan->addr;
+        headers[i].msg_hdr.msg_namelen = sizeof(scan->addr);
+        headers[i].msg_hdr.msg_iov = &iov[i];
+        headers[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int sent = sendmmsg(scan->sockfd, headers, count, 0);
+    if (sent < 0) {
+        if (errno != EAGAIN && errno != ENOBUFS && errno != EINTR) {
+            error_exit("Sendmmsg failed");
+        }
+        sent = 0;
+    }
+
+    uint64_t now_ns = monotonicNs();
+    for (unsigned i = 0; i < count; ++i) {
+        if (i >= (unsigned)sent) {
+            // Not sent at all, try again with the next batch
+            if (ids[i] != SCAN_FENCE) {
+                scan->retry[scan->retry_count++] = ids[i];
+            }
+            continue;
+        }
+        if (ids[i] != SCAN_FENCE) {
+            scan->state[ids[i]] = SCAN_PENDING;
+            scan->attempts[ids[i]]++;
+        }
+        scan->ring[scan->tail++ & scan->ring_mask] = (struct inflight_t){ids[i], now_ns};
+    }
+    scan->sent += sent;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Matches the received replies to the requests
+*
+* @param	scan - scanner state
+*
+* @return	number of replies received
+*
+* @note		Never blocks.
+*
+**************************************************************************/
+static int receiveReplies(struct scanner_t *scan) {
+    uint8_t replies[SCAN_BATCH][16];
+    struct mmsghdr headers[SCAN_BATCH];
+    struct iovec iov[SCAN_BATCH];
+
+    memset(headers, 0, sizeof(headers));
+    for (int i = 0; i < SCAN_BATCH; ++i) {
+        iov[i] = (struct iovec){replies[i], sizeof(replies[i])};
+        headers[i].msg_hdr.msg_iov = &iov[i];
+        headers[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int count = recvmmsg(scan->sockfd, headers, SCAN_BATCH, MSG_DONTWAIT, NULL);
+    if (count < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            error_exit("Recvmmsg failed");
+        }
+        return 0;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        const uint8_t *reply = replies[i];
+        if (headers[i].msg_len < 8 || reply[1] != READ) {
+            continue;
+        }
+        scan->replies++;
+
+        uint16_t object = (reply[2] << 8) | reply[3];
+        uint16_t property = (reply[4] << 8) | reply[5];
+        uint16_t value = (reply[6] << 8) | reply[7];
+
+        if (object >= scan->first_object && (uint32_t)(object - scan->first_object) * SCAN_PROPERTIES < scan->count) {
+            uint32_t id = (object - scan->first_object) * SCAN_PROPERTIES + property;
+            if (scan->state[id] == SCAN_PENDING) {
+                scan->state[id] = SCAN_VALID;
+                scan->value[id] = value;
+                scan->done++;
+                continue;
+            }
+        }
+
+        if (object == scan->fence_object && property == scan->fence_property) {
+            // Everything sent before the oldest fence was handled by the server
+            while (scan->head != scan->tail) {
+                uint32_t id = scan->ring[scan->head++ & scan->ring_mask].id;
+                if (id == SCAN_FENCE) {
+                    break;
+                }
+                expireRequest(scan, id);
+            }
+        }
+    }
+
+    return count;
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Releases answered requests and expires the ones sent too long ago
+*
+* @param	scan - scanner state
+* @param	now_ns - current monotonic time
+*
+* @return	None
+*
+* @note		None
+*
+**************************************************************************/
+static void expireTimeouts(struct scanner_t *scan, uint64_t now_ns) {
+    while (scan->head != scan->tail) {
+        const struct inflight_t *entry = &scan->ring[scan->head & scan->ring_mask];
+        int answered = (entry->id != SCAN_FENCE && scan->state[entry->id] != SCAN_PENDING);
+
+        if (!answered && now_ns - entry->sent_ns < scan->timeout_ns) {
+            break;
+        }
+        scan->head++;
+        expireRequest(scan, entry->id);
+    }
+}
+
+/**************************************************************************/
+/**
+*
+* @brief    Main function for UDP scanner.
+*
+* @param	None
+*
+* @return	None
+*
+* @note		Existing properties are printed to STDOUT as "object.property: name=value",
+*           a summary is printed to STDERR.
+*
+**************************************************************************/
+int main(int argc, char *argv[]) {
+    struct scanner_t scan = {.window = 256, .retries = 1, .timeout_ns = 20000000, .fence_object = CHANNEL_1, .fence_property = ENABLED};
+    unsigned long first_object = CHANNEL_1, last_object = CHANNEL_3;
+    unsigned long udp_port = UDP_PORT;
+    struct sockaddr_in tcp_server_addr;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "f:o:r:t:u:w:h")) != -1) {
+        switch (opt) {
+        case 'f':
+            if (sscanf(optarg, "%hu.%hu", &scan.fence_object, &scan.fence_property) != 2) {
+                optind = argc + 1;
+            }
+            break;
+        case 'o':
+            if (sscanf(optarg, "%lu-%lu", &first_object, &last_object) == 1) {
+                last_object = first_object;
+            }
+            break;
+        case 'r':
+            scan.retries = strtoul(optarg, NULL, 10);
+            break;
+        case 't':
+            scan.timeout_ns = strtoull(optarg, NULL, 10) * 1000000;
+            break;
+        case 'u':
+            udp_port = strtoul(optarg, NULL, 10);
+            break;
+        case 'w':
+            scan.window = strtoul(optarg, NULL, 10);
+            break;
+        default:
+            optind = argc + 1;
+            break;
+        }
+    }
+
+    if (argc - optind > 1 || first_object == 0 || last_object < first_object || last_object > UINT16_MAX ||
+        scan.window == 0 || scan.retries > UINT8_MAX - 1 || udp_port == 0 || udp_port > 65535) {
+        fprintf(stderr, "Usage: %s [-o first_object[-last_object]] [-w window] [-t timeout_ms] [-r retries] [-f object.property] [-u udp_port] [host]\n"
+                        "  -o  objects to scan, 1-3 by default\n"
+                        "  -w  requests in flight, 256 by default\n"
+                        "  -t  time to wait for a reply, 20ms by default\n"
+                        "  -r  times a request without a reply is sent again, 1 by default\n"
+                        "  -f  existing property read after every batch, 1.14 by default\n"
+                        "  -u  control port of the server, 4000 by default\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    // Without a host use the address of the open server port
+    memset(&tcp_server_addr, 0, sizeof(tcp_server_addr));
+    if (optind < argc) {
+        if (inet_pton(AF_INET, argv[optind], &tcp_server_addr.sin_addr) != 1) {
+            error_exit("Invalid host");
+        }
+    } else if (findOpenPort(TCP_PORT, &tcp_server_addr) < 0) {
+        error_exit("An open port could not be found");
+    }
+
+    scan.sockfd = startServer(&tcp_server_addr.sin_addr, udp_port, &scan.addr);
+    int rcvbuf = SCAN_RCVBUF;
+    setsockopt(scan.sockfd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+    uint32_t ring_size = 1;
+    while (ring_size < 2 * (scan.window + SCAN_BATCH)) {
+        ring_size <<= 1;
+    }
+    scan.first_object = first_object;
+    scan.count = (last_object - first_object + 1) * SCAN_PROPERTIES;
+    scan.ring_mask = ring_size - 1;
+    scan.state = calloc(scan.count, sizeof(*scan.state));
+    scan.attempts = calloc(scan.count, sizeof(*scan.attempts));
+    scan.value = calloc(scan.count, sizeof(*scan.value));
+    scan.ring = calloc(ring_size, sizeof(*scan.ring));
+    scan.retry = calloc(scan.window + SCAN_BATCH, sizeof(*scan.retry));
+    if (!scan.state || !scan.attempts || !scan.value || !scan.ring || !scan.retry) {
+        error_exit("Calloc failed");
+    }
+
+    uint64_t start_ns = monotonicNs();
+    while (scan.done < scan.count) {
+        uint64_t sent = scan.sent;
+        uint32_t head = scan.head;
+
+        sendBatch(&scan);
+        int received = receiveReplies(&scan);
+        expireTimeouts(&scan, monotonicNs());
+
+        // Nothing to do until a reply arrives or the oldest request times out
+        if (received == 0 && sent == scan.sent && head == scan.head && scan.head != scan.tail) {
+            struct pollfd pfd = {.fd = scan.sockfd, .events = POLLIN};
+            uint64_t waited_ns = monotonicNs() - scan.ring[scan.head & scan.ring_mask].sent_ns;
+            int timeout_ms = (waited_ns < scan.timeout_ns) ? (scan.timeout_ns - waited_ns) / 1000000 + 1 : 0;
+            poll(&pfd, 1, timeout_ms);
+        }
+    }
+    uint64_t elapsed_ns = monotonicNs() - start_ns;
+
+    uint32_t valid = 0;
+    for (uint32_t id = 0; id < scan.count; ++id) {
+        if (scan.state[id] == SCAN_VALID) {
+            const char *name = propertyName(id % SCAN_PROPERTIES);
+            printf("%u.%u: %s=%u\n", scan.first_object + id / SCAN_PROPERTIES, id % SCAN_PROPERTIES,
+                   name ? name : "unknown", scan.value[id]);
+            valid++;
+        }
+    }
+
+    fprintf(stderr, "Scanned %u properties in %.3f s: %u found, %lu requests sent, %lu resent, %lu replies\n",
+            scan.count, elapsed_ns / 1e9, valid, scan.sent, scan.resent, scan.replies);
+
+    close(scan.sockfd);
+    free(scan.state);
+    free(scan.attempts);
+    free(scan.value);
+    free(scan.ring);
+    free(scan.retry);
+    return 0;
+}